@@ -14,6 +14,7 @@
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <algorithm>
 
 // GLEW
 #include <GL/glew.h>
@@ -36,35 +37,32 @@
 #include "Shader.h"
 #include "Camera.h"
 #include "Model.h"
+#include "ChessRules.h"
+#include "EpdSuite.h"
+#include "Pgn.h"
+#include "GameArchive.h"
+#include "OpeningIndex.h"
+#include "BoardOverlay.h"
+#include "ReplayTimeline.h"
+#include "Perft.h"
+#include "AnalysisFarm.h"
+#include "Throughput.h"
+#include "EnginePlayer.h"
+#include "LiveAnalysis.h"
+#include "MateSolver.h"
+#include "PuzzleMiner.h"
+#include "SelfPlay.h"
+#include "MatchRunner.h"
+#include "AllocationCounter.h"
+#include "PieceSkinArray.h"
+#include "PieceBatcher.h"
+#include "PieceTransformCache.h"
+#include "FrameUniforms.h"
 
 // Estructura de Piezas
 #include <vector>
 #include <map>
 
-// Tipos de Pieza de Ajedrez
-enum PieceType { EMPTY, PAWN, ROOK, KNIGHT, BISHOP, QUEEN, KING };
-// Colores de Pieza de Ajedrez
-enum PieceColor { NONE, WHITE, BLACK }; // NONE se usa para casillas vacías o piezas capturadas
-
-// Estructura para representar una Pieza de Ajedrez en el tablero
-struct ChessPiece {
-    PieceType type = EMPTY;         // Tipo de la pieza (Peón, Torre, etc.)
-    PieceColor color = NONE;        // Color de la pieza (Blanco, Negro)
-    Model* model = nullptr;         // Puntero al modelo 3D que representa la pieza
-    int row = -1;                   // Fila actual de la pieza en el tablero (0-7)
-    int col = -1;                   // Columna actual de la pieza en el tablero (0-7)
-    glm::vec3 positionOffset = glm::vec3(0.0f); // Desplazamiento visual para ajustar el modelo
-    glm::vec3 scale = glm::vec3(1.0f);          // Escala del modelo
-    float rotationY = 0.0f;         // Rotación en el eje Y (en radianes) para orientar el modelo
-    bool isSelected = false;        // true si la pieza está actualmente seleccionada por el jugador
-
-    // Para animación
-    bool isMoving = false;
-    glm::vec3 startPos;
-    glm::vec3 targetPos;
-    float moveProgress = 0.0f;
-    float moveSpeed = 0.2f; // Velocidad de la animación (ajustable)
-};
 // --- Variables Globales del Estado del Juego ---
 // Representación del tablero (8x8)
 ChessPiece board[8][8];
@@ -78,6 +76,8 @@ ChessPiece* selectedPiece = nullptr; // Puntero a la pieza actualmente seleccion
 int selectedRow = -1;                // Fila de la pieza seleccionada
 int selectedCol = -1;                // Columna de la pieza seleccionada
 PieceColor currentPlayer = WHITE;    // Jugador cuyo turno es actualmente
+uint8_t castlingRights = CASTLE_ALL; // Enroques que todavía se pueden hacer (CASTLE_*)
+int enPassantCol = -1;               // Columna donde se puede capturar al paso, -1 si no hay
 
 // --- Constantes de Configuración del Tablero y Escena ---
 const float TILE_SIZE = 5.0f;         // Tamaño de una casilla del tablero en unidades del mundo
@@ -95,6 +95,40 @@ const float CAPTURED_Z_START = BOARD_OFFSET_Z;
 int whiteCapturedCount = 0;
 int blackCapturedCount = 0;
 
+// Apariencia (modelo, offset, escala, rotación) de cada tipo de pieza por color.
+// Se llena en InitializeBoard y se usa para dibujar posiciones que no vienen de la partida inicial.
+ChessPiece pieceStyles[3][7];
+
+// --- Reproducción de partidas guardadas (--view archivo.bin N) ---
+GameArchive replayArchive;
+ReplayTimeline replayTimeline;
+bool replayMode = false;   // true mientras se reproduce una partida: el ratón no mueve piezas
+int replayPly = 0;         // Número de jugadas aplicadas a la posición que se muestra
+bool replayDragging = false;  // true mientras se arrastra con el botón derecho para recorrer la partida
+bool replayScrubbing = false; // true si las jugadas se están recorriendo más rápido que la animación
+double lastSeekTime = -1.0;
+const double REPLAY_SCRUB_INTERVAL = 0.25; // Segundos entre saltos por debajo de los cuales no se anima
+BoardOverlay replayOverlay;   // Barra de progreso de la reproducción
+
+// --- Explorador de aperturas (--book aperturas.idx) ---
+OpeningIndex openingBook;
+BoardOverlay boardOverlay; // Casillas coloreadas con las estadísticas de la pieza seleccionada
+
+// --- Motor rival (--engine [milisegundos por jugada]) ---
+EnginePlayer enginePlayer;
+PieceColor engineColor = NONE; // Color que juega el motor; NONE si juegan dos personas
+
+// --- Análisis con las mejores líneas (tecla M, o --multipv N al iniciar) ---
+LiveAnalysis liveAnalysis;
+BoardOverlay analysisOverlay; // Flechas de las mejores jugadas
+bool analysisEnabled = false;
+int analysisLines = 3;        // Número de líneas (MultiPV)
+uint64_t analysedKey = 0;     // Clave de la posición que se está analizando
+SearchResult analysisResult;  // Última profundidad recibida; se reutiliza para no reservar en cada cuadro
+
+// Un cuadro del ciclo principal no debe reservar memoria; se cuenta para comprobarlo
+FrameAllocationStats frameAllocations;
+
 // Function prototypes
 void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mode);
 void MouseCallback(GLFWwindow* window, double xPos, double yPos);
@@ -105,14 +139,27 @@ void InitializeBoard(
     Model* pPeonB, Model* pTorreB, Model* pCaballoB, Model* pAlfilB, Model* pReinaB, Model* pReyB
 );//Configura las piezas en sus posiciones iniciales en el tablero.
 glm::vec3 GetWorldCoordinates(int row, int col); // Convierte coordenadas de tablero (fila, col) a coordenadas del mundo (x, y, z).
-bool IsPathClear(int startRow, int startCol, int endRow, int endCol); // Verifica si no hay obstáculos entre dos casillas para movimientos rectilíneos.
-bool IsValidMove(ChessPiece* piece, int targetRow, int targetCol);
+glm::vec3 GetCapturedCoordinates(PieceColor color, size_t index); // Lugar de la index-ésima pieza capturada de un color, junto al tablero.
 bool WorldToBoardCoordinates(const glm::vec3& worldPos, int& row, int& col);
 glm::vec3 CalculateMouseRay(GLFWwindow* window, double xpos, double ypos, const Camera& cam, const glm::mat4& projectionMatrix);
 float RayPlaneIntersection(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, const glm::vec3& planePoint, const glm::vec3& planeNormal);
 glm::vec3 GetBoardIntersectionPoint(GLFWwindow* window, double xpos, double ypos, const Camera& cam);
 void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void MoveCapturedPiece(ChessPiece& piece);
+bool RunCommandLineTool(int argc, char* argv[], int& exitCode); // Ejecuta la herramienta pedida en argv, si la hay.
+void ApplyPieceStyle(ChessPiece& piece); // Asigna a la pieza el modelo y ajustes de su tipo y color.
+bool PieceStylesHaveUniformScale(); // true si todas las piezas tienen la misma escala en los tres ejes (salvo el signo).
+void ShowPosition(const Position& pos); // Coloca en el tablero de la ventana una posición de las reglas.
+bool LoadArchivedGame(const std::string& path, uint32_t gameIndex); // Abre una partida del archivo binario para reproducirla.
+void SeekReplay(int ply); // Muestra la partida reproducida después de ply jugadas.
+Position CurrentPosition(); // Posición que se muestra en la ventana, en el formato de las reglas.
+void ShowOpeningStats(int row, int col); // Marca en el tablero las jugadas del libro para la pieza en (row, col).
+void ApplyBoardMove(const ChessMove& move); // Hace un movimiento en el tablero de la ventana, con animación y cambio de turno.
+void UpdateEngine(); // Juega la jugada del motor cuando termina de pensar.
+void UpdateAnalysis(); // Reinicia el análisis si cambió la posición y redibuja sus flechas.
+
+// Matrices de las piezas; se recalculan solo en las casillas marcadas al mover, animar o cambiar la posición
+PieceTransformCache pieceTransforms(GetWorldCoordinates, GetCapturedCoordinates);
 
 // Window dimensions
 const GLuint WIDTH = 1200, HEIGHT = 1000;
@@ -149,8 +196,14 @@ glm::vec3 Light1 = glm::vec3(0);
 GLfloat deltaTime = 0.0f;
 GLfloat lastFrame = 0.0f;
 
-int main()
+int main(int argc, char* argv[])
 {
+    // Herramientas de línea de comandos: se ejecutan sin abrir la ventana
+    int toolExitCode;
+    if (RunCommandLineTool(argc, argv, toolExitCode)) {
+        return toolExitCode;
+    }
+
     glfwInit();
     GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Ajedrez 3D", nullptr, nullptr);
 
@@ -176,7 +229,13 @@ int main()
 
     glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 
+    // Cámara y luz de cada cuadro, en un búfer que leen todos los shaders
+    FrameUniforms frameUniforms;
+    frameUniforms.Init();
     Shader lightingShader("Shader/lighting.vs", "Shader/lighting.frag");
+    Shader overlayShader("Shader/core.vs", "Shader/core.frag");
+    boardOverlay.Init();
+    replayOverlay.Init(2); // Fondo y avance de la barra
 
     // Carga de modelos
     Model Piso((char*)"Models/Minecraft/tablero2.obj");
@@ -199,15 +258,74 @@ int main()
         &pollo, &golem, &caballo, &perro, &alex, &steve,
         &esqueleto, &piglin, &blaze, &enderman, &dragon, &warden
     );
+    // Con la misma escala en los tres ejes, mat3(model) orienta bien las normales y las piezas
+    // usan la variante del shader que no lee la matriz de normales
+    const char* pieceVertexShader = PieceStylesHaveUniformScale() ? "Shader/instanced_uniform.vs" : "Shader/instanced.vs";
+    Shader instancedShader(pieceVertexShader, "Shader/instanced.frag");
+    // Los materiales de cada malla se resuelven desde la carga: el tablero para el shader de
+    // iluminación y las piezas para el instanciado
+    Piso.Bake(lightingShader);
+    Model* pieceModels[] = { &steve, &alex, &golem, &caballo, &perro, &pollo,
+        &warden, &dragon, &piglin, &blaze, &enderman, &esqueleto };
+    for (Model* pieceModel : pieceModels) {
+        pieceModel->Bake(instancedShader);
+    }
+    // Las pieles de las piezas van juntas en un arreglo de texturas
+    PieceSkinArray pieceSkins;
+    pieceSkins.Build(pieceModels, sizeof(pieceModels) / sizeof(pieceModels[0]));
+    // Todas las mallas ya están en el búfer de geometría compartido; Init lo sube y le conecta
+    // el búfer de instancias
+    PieceBatcher pieceBatcher;
+    pieceBatcher.Init(pieceSkins);
+
+    // Reproducir una partida de un archivo binario en lugar de jugar una nueva
+    if (argc >= 3 && std::string(argv[1]) == "--view") {
+        uint32_t gameIndex = (argc >= 4) ? (uint32_t)std::atoi(argv[3]) : 0;
+        if (!LoadArchivedGame(argv[2], gameIndex)) {
+            std::cout << "No se pudo abrir la partida " << gameIndex << " de " << argv[2] << std::endl;
+        }
+    }
+    // Índice de aperturas para mostrar estadísticas al seleccionar una pieza
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--book" && !openingBook.Open(argv[i + 1])) {
+            std::cout << "No se pudo abrir el indice de aperturas " << argv[i + 1] << std::endl;
+        }
+    }
+    // Jugar contra el motor: la persona lleva las blancas y el motor las negras
+    for (int i = 1; i < argc && !replayMode; ++i) {
+        if (std::string(argv[i]) == "--engine") {
+            engineColor = BLACK;
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0) {
+                enginePlayer.SetThinkTime(std::atoi(argv[i + 1]) / 1000.0);
+            }
+        }
+        if (std::string(argv[i]) == "--multipv" && i + 1 < argc && std::atoi(argv[i + 1]) > 0) {
+            analysisLines = std::atoi(argv[i + 1]);
+            analysisEnabled = true;
+        }
+    }
+    analysisOverlay.Init(2 * analysisLines); // Cuerpo y punta de la flecha de cada línea
 
     lightingShader.Use();
-    glUniform1i(glGetUniformLocation(lightingShader.Program, "Material.difuse"), 0);
-    glUniform1i(glGetUniformLocation(lightingShader.Program, "Material.specular"), 1);
+    lightingShader.SetInt("Material.difuse", 0);
+    lightingShader.SetInt("Material.specular", 1);
+    lightingShader.SetInt("diffuse", 0);
+    lightingShader.SetVec3("highlightColor", glm::vec3(0.0f)); // El tablero nunca se resalta
+    // El tablero no se mueve: su matriz y su matriz de normales se calculan y asignan una vez
+    glm::mat4 boardModel = glm::mat4(1.0f);
+    boardModel = glm::scale(boardModel, glm::vec3(82.0f, 75.0f, 84.0f));
+    boardModel = glm::translate(boardModel, glm::vec3(0.0f, -0.054f, 0.25f));
+    boardModel = glm::rotate(boardModel, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    lightingShader.SetMat4("model", boardModel);
+    lightingShader.SetMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(boardModel))));
+    instancedShader.Use();
+    instancedShader.SetInt("pieceSkins", 0); // PieceBatcher enlaza el arreglo de pieles en la unidad 0
 
     glm::mat4 projection = glm::perspective(camera.GetZoom(), (GLfloat)SCREEN_WIDTH / (GLfloat)SCREEN_HEIGHT, 0.1f, 100.0f);
 
     while (!glfwWindowShouldClose(window))
     {
+        frameAllocations.BeginFrame();
         GLfloat currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
@@ -215,118 +333,210 @@ int main()
         glfwPollEvents();
         DoMovement();
         UpdateAnimations(deltaTime);
+        UpdateEngine();
+        UpdateAnalysis();
 
+        GLState().BeginFrame();
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
+        GLState().Enable(GL_DEPTH_TEST);
 
-        lightingShader.Use();
-        glUniform1i(glGetUniformLocation(lightingShader.Program, "diffuse"), 0);
         // Obtener la matriz de vista de la cámara activa
-        glm::mat4 view;
-        if (useSideCamera) {
-            view = cameraSideView.GetViewMatrix();
-        }
-        else {
-            view = camera.GetViewMatrix();
-        }
-        GLint modelLoc = glGetUniformLocation(lightingShader.Program, "model");
-        GLint viewLoc = glGetUniformLocation(lightingShader.Program, "view");
-        GLint projLoc = glGetUniformLocation(lightingShader.Program, "projection");
+        const Camera& activeCamera = useSideCamera ? cameraSideView : camera;
+        glm::mat4 view = activeCamera.GetViewMatrix();
+        frameUniforms.Update(view, projection, activeCamera.GetPosition(), lightPos, glm::vec3(1.0f));
 
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-        // Dibujar el tablero
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::scale(model, glm::vec3(82.0f, 75.0f, 84.0f));
-        model = glm::translate(model, glm::vec3(0.0f, -0.054f, 0.25f));
-        model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        Piso.Draw(lightingShader);
+        // Las piezas se ordenan por modelo y distancia y se dibujan instanciadas antes que el
+        // tablero: tapan parte de él, y así esos fragmentos del tablero se descartan por
+        // profundidad antes de sombrearse
+        pieceBatcher.Begin(activeCamera.GetPosition());
 
-        // Dibujar las piezas en el tablero
+        // Piezas en el tablero
         for (int r = 0; r < 8; ++r) {
             for (int c = 0; c < 8; ++c) {
                 ChessPiece& piece = board[r][c];
                 if (piece.type != EMPTY && piece.model != nullptr) {
-                    glm::mat4 model = glm::mat4(1.0f);
-                    glm::vec3 worldPos = GetWorldCoordinates(r, c);
-
-                    // Aplicar offset de animación si la pieza se está moviendo
-                    if (piece.isMoving) {
-                        worldPos += piece.positionOffset;
-                    }
-                    else {
-                        worldPos += piece.positionOffset; // Para otros offsets estáticos
-                    }
-
-                    model = glm::translate(model, worldPos);
-                    if (piece.rotationY != 0.0f) {
-                        model = glm::rotate(model, piece.rotationY, glm::vec3(0.0f, 1.0f, 0.0f));
-                    }
-                    model = glm::scale(model, piece.scale);
-
-                    if (piece.isSelected) {
-                        glm::vec3 highlightColor = glm::vec3(1.0f, 1.0f, 0.0f);
-                        glUniform3f(glGetUniformLocation(lightingShader.Program, "highlightColor"), highlightColor.x, highlightColor.y, highlightColor.z);
-                    }
-                    else {
-                        glUniform3f(glGetUniformLocation(lightingShader.Program, "highlightColor"), 0.0f, 0.0f, 0.0f);
-                    }
-
-                    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-                    piece.model->Draw(lightingShader);
+                    glm::vec3 highlightColor = piece.isSelected ? glm::vec3(1.0f, 1.0f, 0.0f) : glm::vec3(0.0f);
+                    const PieceTransform& transform = pieceTransforms.Square(r, c, piece);
+                    pieceBatcher.Add(piece.model, transform.world, transform.normal, highlightColor);
                 }
             }
         }
 
-        // Dibujar piezas capturadas blancas
+        // Piezas capturadas blancas
         for (size_t i = 0; i < whiteCapturedPieces.size(); i++) {
             ChessPiece& piece = whiteCapturedPieces[i];
             if (piece.model != nullptr) {
-                glm::mat4 model = glm::mat4(1.0f);
-                float worldX = CAPTURED_WHITE_X;
-                float worldZ = CAPTURED_Z_START + i * TILE_SIZE * 0.5f;
-                model = glm::translate(model, glm::vec3(worldX, CAPTURED_Y, worldZ));
-                if (piece.rotationY != 0.0f) {
-                    model = glm::rotate(model, piece.rotationY, glm::vec3(0.0f, 1.0f, 0.0f));
-                }
-                model = glm::scale(model, piece.scale);
-                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-                piece.model->Draw(lightingShader);
+                const PieceTransform& transform = pieceTransforms.Captured(WHITE, i, piece);
+                pieceBatcher.Add(piece.model, transform.world, transform.normal, glm::vec3(0.0f));
             }
         }
 
-        // Dibujar piezas capturadas negras
+        // Piezas capturadas negras
         for (size_t i = 0; i < blackCapturedPieces.size(); i++) {
             ChessPiece& piece = blackCapturedPieces[i];
             if (piece.model != nullptr) {
-                glm::mat4 model = glm::mat4(1.0f);
-                float worldX = CAPTURED_BLACK_X;
-                float worldZ = CAPTURED_Z_START + i * TILE_SIZE * 0.5f;
-                model = glm::translate(model, glm::vec3(worldX, CAPTURED_Y, worldZ));
-                if (piece.rotationY != 0.0f) {
-                    model = glm::rotate(model, piece.rotationY, glm::vec3(0.0f, 1.0f, 0.0f));
-                }
-                model = glm::scale(model, piece.scale);
-                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-                piece.model->Draw(lightingShader);
+                const PieceTransform& transform = pieceTransforms.Captured(BLACK, i, piece);
+                pieceBatcher.Add(piece.model, transform.world, transform.normal, glm::vec3(0.0f));
             }
         }
+
+        pieceBatcher.Draw(instancedShader);
+
+        // Dibujar el tablero
+        lightingShader.Use();
+        Piso.Draw(lightingShader);
+
+        // Estadísticas del explorador de aperturas sobre las casillas destino
+        boardOverlay.Draw(overlayShader);
+        replayOverlay.Draw(overlayShader);
+        analysisOverlay.Draw(overlayShader);
         glfwSwapBuffers(window);
+
+        // Se informa solo el primero para no reservar (y llenar la consola) en cada cuadro
+        uint64_t allocated = frameAllocations.EndFrame();
+        if (allocated > 0 && frameAllocations.allocatingFrames == 1) {
+            std::cerr << "ERROR::RENDER::RESERVAS_EN_CUADRO " << allocated << " reservas en el cuadro "
+                << frameAllocations.frames << std::endl;
+        }
+    }
+    std::cout << "Render: " << frameAllocations.frames << " cuadros, " << frameAllocations.allocations
+        << " reservas de memoria en " << frameAllocations.steadyFrames << " cuadros sin cambios despues de "
+        << FrameAllocationStats::WARMUP_FRAMES << " de calentamiento (" << frameAllocations.allocatingFrames
+        << " cuadros con reservas)" << std::endl;
+    if (frameAllocations.allocatingFrames > 0) {
+        std::cerr << "ERROR::RENDER::RESERVAS_EN_CUADRO " << frameAllocations.allocatingFrames
+            << " cuadros sin cambios reservaron memoria" << std::endl;
     }
+    std::cout << "Piezas: " << pieceBatcher.InstanceCount() << " dibujadas con " << pieceBatcher.DrawCalls()
+        << " envios de dibujo en el ultimo cuadro (" << SharedGeometry().VertexCount() << " vertices en el bufer compartido), "
+        << pieceBatcher.Queue().StateChanges() << " cambios de estado y " << pieceBatcher.Queue().StateChangesAvoided()
+        << " evitados al ordenar" << std::endl;
+    std::cout << "Matrices de piezas: " << pieceTransforms.Recomputed() << " calculadas en " << frameAllocations.frames
+        << " cuadros" << std::endl;
+    std::cout << "Estado GL: " << GLState().AverageIssued() << " enlaces por cuadro enviados al driver, "
+        << GLState().AverageSkipped() << " omitidos por redundantes" << std::endl;
     glfwTerminate();
     return 0;
 }
 
+/**
+ * @brief Ejecuta una herramienta de línea de comandos si argv la pide.
+ * --epd archivo [hilos] [nodos]  Cuenta los movimientos legales de cada posición de una suite EPD (con nodos, también busca la mejor jugada y la compara con "bm").
+ * --pgn archivo [hilos]  Reproduce y valida todas las partidas de un archivo PGN.
+ * --pgn2bin archivo.pgn archivo.bin [hilos]  Convierte un PGN al formato binario de GameArchive.h.
+ * --book-build partidas.(pgn|bin) aperturas.idx [hilos]  Construye el índice del explorador de aperturas.
+ * --book-probe aperturas.idx "FEN"  Muestra las estadísticas del índice para una posición.
+ * --perft profundidad ["FEN"] [hilos] [MB de tabla]  Cuenta los nodos del árbol de movimientos.
+ * --farm corpus.epd resultados.txt [procesos] [nodos]  Analiza un corpus EPD repartido entre varios procesos (como --epd).
+ * --throughput suite.epd nodos [hilos]  Busca cada posición en un solo hilo y mide posiciones/s por número de hilos.
+ * --mate-suite problemas.epd [MB de tabla] [nodos]  Prueba los mates "dm N" de una suite con df-pn.
+ * --puzzles partidas.(pgn|bin) problemas.epd [hilos] [nodos]  Extrae problemas tácticos de un corpus de partidas.
+ * --selfplay datos.bin partidas nodos [hilos]  Genera posiciones de entrenamiento jugando el motor contra sí mismo.
+ * --match A B partidas [hilos] [aperturas.epd]  Enfrenta dos configuraciones ("nodos" o "dN") con SPRT.
+ * @return true si se ejecutó una herramienta (su código de salida queda en exitCode).
+ */
+bool RunCommandLineTool(int argc, char* argv[], int& exitCode) {
+    if (argc < 3) {
+        return false;
+    }
+    std::string tool = argv[1];
+    int threads = (argc >= 4) ? std::atoi(argv[3]) : 0;
+    if (tool == "--epd") {
+        uint64_t nodeLimit = (argc >= 5) ? std::strtoull(argv[4], nullptr, 10) : 0;
+        exitCode = RunEpdSuite(argv[2], threads, nodeLimit, std::cout);
+        return true;
+    }
+    if (tool == "--pgn") {
+        exitCode = RunPgnValidator(argv[2], threads, std::cout);
+        return true;
+    }
+    if (tool == "--pgn2bin" && argc >= 4) {
+        exitCode = ConvertPgnToArchive(argv[2], argv[3], (argc >= 5) ? std::atoi(argv[4]) : 0);
+        return true;
+    }
+    if (tool == "--book-build" && argc >= 4) {
+        exitCode = BuildOpeningIndex(argv[2], argv[3], (argc >= 5) ? std::atoi(argv[4]) : 0);
+        return true;
+    }
+    if (tool == "--book-probe" && argc >= 4) {
+        exitCode = ProbeOpeningIndex(argv[2], argv[3], std::cout);
+        return true;
+    }
+    if (tool == "--farm" && argc >= 4) {
+        uint64_t nodeLimit = (argc >= 6) ? std::strtoull(argv[5], nullptr, 10) : 0;
+        exitCode = RunAnalysisFarm(argv[0], argv[2], argv[3], (argc >= 5) ? std::atoi(argv[4]) : 0, nodeLimit);
+        return true;
+    }
+    if (tool == "--farm-worker" && argc >= 5) {
+        uint64_t nodeLimit = (argc >= 6) ? std::strtoull(argv[5], nullptr, 10) : 0;
+        exitCode = RunFarmWorker(argv[2], std::atoi(argv[3]), std::atoi(argv[4]), nodeLimit);
+        return true;
+    }
+    if (tool == "--throughput" && argc >= 4) {
+        uint64_t nodeLimit = std::strtoull(argv[3], nullptr, 10);
+        exitCode = RunThroughputBenchmark(argv[2], nodeLimit, (argc >= 5) ? std::atoi(argv[4]) : 0, std::cout);
+        return true;
+    }
+    if (tool == "--mate-suite") {
+        size_t mateMegabytes = (argc >= 4) ? (size_t)std::atoi(argv[3]) : 64;
+        uint64_t maxNodes = (argc >= 5) ? std::strtoull(argv[4], nullptr, 10) : 0;
+        exitCode = RunMateSuite(argv[2], mateMegabytes, maxNodes, std::cout);
+        return true;
+    }
+    if (tool == "--puzzles" && argc >= 4) {
+        uint64_t shallowNodes = (argc >= 6) ? std::strtoull(argv[5], nullptr, 10) : 2000;
+        exitCode = MinePuzzles(argv[2], argv[3], (argc >= 5) ? std::atoi(argv[4]) : 0, shallowNodes);
+        return true;
+    }
+    if (tool == "--selfplay" && argc >= 5) {
+        uint64_t nodeLimit = std::strtoull(argv[4], nullptr, 10);
+        exitCode = RunSelfPlay(argv[2], std::atoi(argv[3]), nodeLimit, (argc >= 6) ? std::atoi(argv[5]) : 0);
+        return true;
+    }
+    if (tool == "--match" && argc >= 5) {
+        exitCode = RunMatch(argv[2], argv[3], std::atoi(argv[4]), (argc >= 6) ? std::atoi(argv[5]) : 0,
+            (argc >= 7) ? argv[6] : "", std::cout);
+        return true;
+    }
+    if (tool == "--perft") {
+        std::string fen = (argc >= 4) ? argv[3] : START_FEN;
+        int perftThreads = (argc >= 5) ? std::atoi(argv[4]) : 0;
+        size_t hashMegabytes = (argc >= 6) ? (size_t)std::atoi(argv[5]) : 64;
+        exitCode = RunPerft(fen, std::atoi(argv[2]), perftThreads, hashMegabytes, std::cout);
+        return true;
+    }
+    return false;
+}
+
 void UpdateAnimations(float deltaTime) {
+    // Al recorrer una reproducción rápido no se anima nada: cada pieza salta a su casilla
+    if (replayScrubbing) {
+        if (glfwGetTime() - lastSeekTime >= REPLAY_SCRUB_INTERVAL) {
+            replayScrubbing = false;
+        }
+        for (int r = 0; r < 8; ++r) {
+            for (int c = 0; c < 8; ++c) {
+                ChessPiece& piece = board[r][c];
+                if (piece.isMoving) {
+                    piece.isMoving = false;
+                    piece.moveProgress = 1.0f;
+                    piece.positionOffset.x = 0.0f;
+                    piece.positionOffset.z = 0.0f;
+                    pieceTransforms.InvalidateSquare(r, c);
+                }
+            }
+        }
+        return;
+    }
+
     for (int r = 0; r < 8; ++r) {
         for (int c = 0; c < 8; ++c) {
             ChessPiece& piece = board[r][c];
             if (piece.isMoving) {
                 float staticOffsetY = piece.positionOffset.y; // Guarda el Y actual (debería ser el estático)
                 piece.moveProgress += piece.moveSpeed * deltaTime;
+                pieceTransforms.InvalidateSquare(r, c); // Cada paso de la animación mueve la pieza
 
                 if (piece.moveProgress >= 1.0f) {
                     piece.moveProgress = 1.0f; // Asegura que termine exactamente en 1.0
@@ -369,6 +579,144 @@ void MoveCapturedPiece(ChessPiece& piece) {
     piece.color = NONE;
     piece.model = nullptr;
 }
+// Mueve la pieza de una casilla vacía a otra y la anima (la torre del enroque)
+void SlideBoardPiece(int row, int fromCol, int toCol) {
+    board[row][toCol] = board[row][fromCol];
+    board[row][toCol].col = toCol;
+    board[row][fromCol] = ChessPiece();
+    board[row][fromCol].row = row;
+    board[row][fromCol].col = fromCol;
+    pieceTransforms.InvalidateSquare(row, fromCol);
+    pieceTransforms.InvalidateSquare(row, toCol);
+
+    ChessPiece& rook = board[row][toCol];
+    rook.isMoving = true;
+    rook.startPos = GetWorldCoordinates(row, fromCol);
+    rook.targetPos = GetWorldCoordinates(row, toCol);
+    rook.moveProgress = 0.0f;
+}
+
+/**
+ * @brief Hace un movimiento ya validado en el tablero de la ventana.
+ * Captura la pieza del destino (o el peón capturado al paso), anima la pieza que se mueve
+ * (y la torre si es un enroque), corona si el movimiento lo indica y cambia el turno.
+ */
+void ApplyBoardMove(const ChessMove& move) {
+    frameAllocations.MarkStateChange(); // Historial, capturas y el motor pueden reservar
+    // Derechos de enroque y captura al paso después del movimiento, con las mismas reglas del motor
+    Position after = CurrentPosition();
+    bool castles = IsCastlingMove(after, move);
+    bool enPassant = IsEnPassantMove(after, move);
+    MoveUndo undo;
+    MakeMove(after, move, undo);
+    castlingRights = after.castling;
+    enPassantCol = after.enPassantCol;
+
+    ChessPiece& targetSquare = board[move.toRow][move.toCol];
+    // Si hay una pieza enemiga en la casilla destino, capturarla
+    if (targetSquare.type != EMPTY) {
+        MoveCapturedPiece(targetSquare); // Mueve la pieza *antes* de sobrescribirla
+    }
+    else if (enPassant) {
+        // El peón capturado al paso está junto a la casilla de origen, no en el destino
+        MoveCapturedPiece(board[move.fromRow][move.toCol]);
+        pieceTransforms.InvalidateSquare(move.fromRow, move.toCol);
+    }
+    if (castles) {
+        bool kingSide = move.toCol > move.fromCol;
+        SlideBoardPiece(move.fromRow, kingSide ? 7 : 0, kingSide ? 5 : 3);
+    }
+
+    // 1. Mover la pieza a la casilla destino
+    ChessPiece pieceToMove = board[move.fromRow][move.fromCol]; // Crea una copia temporal
+    pieceToMove.row = move.toRow;
+    pieceToMove.col = move.toCol;
+    pieceToMove.isSelected = false; // Ya no está seleccionada
+    if (move.promotion != EMPTY) {
+        pieceToMove.type = move.promotion;
+        ApplyPieceStyle(pieceToMove);
+    }
+
+    // 2. Vacía la casilla original LÓGICA
+    board[move.fromRow][move.fromCol] = ChessPiece();
+    board[move.fromRow][move.fromCol].row = move.fromRow;
+    board[move.fromRow][move.fromCol].col = move.fromCol;
+
+    // 3. Coloca la pieza copiada en la casilla destino LÓGICA
+    board[move.toRow][move.toCol] = pieceToMove;
+
+    pieceTransforms.InvalidateSquare(move.fromRow, move.fromCol);
+    pieceTransforms.InvalidateSquare(move.toRow, move.toCol);
+
+    // 4. Configura la animación en la pieza que AHORA está en la casilla destino
+    ChessPiece& movingPiece = board[move.toRow][move.toCol];
+    movingPiece.isMoving = true;
+    movingPiece.startPos = GetWorldCoordinates(move.fromRow, move.fromCol); // Posición inicial ANTES del movimiento
+    movingPiece.targetPos = GetWorldCoordinates(move.toRow, move.toCol);   // Posición final
+    movingPiece.moveProgress = 0.0f;
+
+    // Deseleccionar
+    selectedPiece = nullptr;
+    selectedRow = -1;
+    selectedCol = -1;
+
+    // CAMBIO DE TURNO
+    currentPlayer = (currentPlayer == WHITE) ? BLACK : WHITE;
+
+    // Sin jugadas legales la partida terminó
+    std::vector<ChessMove> replies;
+    GenerateMoves(after, replies);
+    if (replies.empty() && IsInCheck(after)) {
+        std::cout << "Jaque mate: ganan las " << (currentPlayer == WHITE ? "negras" : "blancas") << std::endl;
+    }
+    else if (replies.empty()) {
+        std::cout << "Ahogado: tablas" << std::endl;
+    }
+}
+
+void UpdateEngine() {
+    if (engineColor == NONE || currentPlayer != engineColor) {
+        return;
+    }
+    ChessMove move;
+    if (enginePlayer.PollMove(move)) {
+        ApplyBoardMove(move);
+    }
+}
+
+void UpdateAnalysis() {
+	if (!analysisEnabled) {
+		return;
+	}
+	Position pos = CurrentPosition();
+	uint64_t key = PositionKey(pos);
+	if (key != analysedKey) {
+		analysedKey = key;
+		analysisOverlay.Clear();
+		liveAnalysis.Start(pos, analysisLines);
+		frameAllocations.MarkStateChange();
+	}
+
+	if (!liveAnalysis.TakeUpdate(analysisResult)) {
+		return;
+	}
+	const SearchResult& result = analysisResult;
+	// Una flecha por línea: la mejor más ancha y verde, las siguientes más delgadas y rojizas
+	const glm::vec3 lineColors[] = {
+		glm::vec3(0.1f, 0.8f, 0.2f), glm::vec3(0.9f, 0.8f, 0.1f), glm::vec3(0.9f, 0.5f, 0.1f), glm::vec3(0.8f, 0.2f, 0.2f)
+	};
+	analysisOverlay.Clear();
+	for (size_t i = 0; i < result.lines.size(); ++i) {
+		const SearchLine& line = result.lines[i];
+		const ChessMove& move = line.pv[0];
+		glm::vec3 from = GetWorldCoordinates(move.fromRow, move.fromCol);
+		glm::vec3 to = GetWorldCoordinates(move.toRow, move.toCol);
+		from.y = to.y = PIECE_Y_OFFSET + 0.2f + 0.01f * i; // Apenas sobre el tablero, sin pelear por profundidad
+		float width = TILE_SIZE * glm::max(0.22f - 0.04f * i, 0.08f);
+		analysisOverlay.AddArrow(from, to, width, lineColors[glm::min(i, (size_t)3)]);
+	}
+}
+
 /**
  * @brief Callback para eventos de clic del ratón.
  * Gestiona la selección de piezas, validación de movimientos y ejecución de movimientos/capturas.
@@ -378,6 +726,23 @@ void MoveCapturedPiece(ChessPiece& piece) {
  * @param mods Modificadores de teclado (Shift, Ctrl, etc.).
  */
 void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+    frameAllocations.MarkStateChange();
+    if (replayMode) {
+        // Durante la reproducción el ratón no mueve piezas: arrastrar con el botón derecho
+        // a lo ancho de la ventana recorre la partida como una barra de desplazamiento
+        if (button == GLFW_MOUSE_BUTTON_RIGHT) {
+            replayDragging = (action == GLFW_PRESS);
+            if (replayDragging) {
+                double xpos, ypos;
+                glfwGetCursorPos(window, &xpos, &ypos);
+                MouseCallback(window, xpos, ypos);
+            }
+        }
+        return;
+    }
+    if (currentPlayer == engineColor) {
+        return; // Turno del motor
+    }
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
         double xpos, ypos; // Obtener posición actual del cursor
         glfwGetCursorPos(window, &xpos, &ypos);
@@ -406,45 +771,24 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
                     }
                 }
                 else {
-                    // Dentro del if (IsValidMove(...)) en MouseButtonCallback:
-                    // Ya hay una pieza seleccionada, intentar moverla o cambiar selección
-                    if (IsValidMove(selectedPiece, targetRow, targetCol)) {
-                        selectedPiece->isSelected = false;
-                        ChessPiece& targetSquare = board[targetRow][targetCol];
-                        // Si hay una pieza enemiga en la casilla destino, capturarla
-                        if (targetSquare.type != EMPTY) {
-                            MoveCapturedPiece(targetSquare); // Mueve la pieza *antes* de sobrescribirla
+                    // Ya hay una pieza seleccionada, intentar moverla o cambiar selección.
+                    // El movimiento tiene que estar entre las jugadas legales (con enroque, captura
+                    // al paso y sin dejar al rey en jaque); un peón que llega a la última fila
+                    // corona siempre en dama, la primera coronación de la lista.
+                    std::vector<ChessMove> legalMoves;
+                    GenerateMoves(CurrentPosition(), legalMoves);
+                    auto legal = std::find_if(legalMoves.begin(), legalMoves.end(), [&](const ChessMove& candidate) {
+                        return candidate.fromRow == selectedRow && candidate.fromCol == selectedCol &&
+                            candidate.toRow == targetRow && candidate.toCol == targetCol;
+                    });
+                    if (legal != legalMoves.end()) {
+                        ChessMove move = *legal;
+                        ApplyBoardMove(move);
+
+                        // Avisar al motor: si era la jugada que esperaba sigue la búsqueda que ya tenía
+                        if (engineColor == currentPlayer) {
+                            enginePlayer.OpponentMoved(move, CurrentPosition());
                         }
-
-                        // 1. Mover la pieza seleccionada a la casilla destino
-                        ChessPiece pieceToMove = *selectedPiece; // Crea una copia temporal
-                        pieceToMove.row = targetRow;
-                        pieceToMove.col = targetCol;
-                        pieceToMove.isSelected = false; // Ya no está seleccionada
-
-                        // 2. Vacía la casilla original LÓGICA
-                        board[selectedRow][selectedCol] = ChessPiece();
-                        board[selectedRow][selectedCol].row = selectedRow;
-                        board[selectedRow][selectedCol].col = selectedCol;
-
-                        // 3. Coloca la pieza copiada en la casilla destino LÓGICA
-                        board[targetRow][targetCol] = pieceToMove;
-
-                        // 4. Configura la animación en la pieza que AHORA está en la casilla destino
-                        ChessPiece& movingPiece = board[targetRow][targetCol]; // Obtén referencia a la pieza movida
-                        movingPiece.isMoving = true;
-                        movingPiece.startPos = GetWorldCoordinates(selectedRow, selectedCol); // Posición inicial ANTES del movimiento
-                        movingPiece.targetPos = GetWorldCoordinates(targetRow, targetCol);   // Posición final
-                        movingPiece.moveProgress = 0.0f;
-                        // movingPiece.moveSpeed = 1.0f; // <-- AJUSTA ESTE VALOR si 0.2f es muy rápido o lento una vez funcione
-
-                        // Deseleccionar
-                        selectedPiece = nullptr;
-                        selectedRow = -1;
-                        selectedCol = -1;
-
-                        // CAMBIO DE TURNO (ver siguiente punto)
-                        currentPlayer = (currentPlayer == WHITE) ? BLACK : WHITE; 
                     }
                    // Limpiar el estado de selección
                     else {// El movimiento no es válido
@@ -466,6 +810,8 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
                         }
                     }
                 }
+                // Mostrar (o quitar) las estadísticas del libro para la selección actual
+                ShowOpeningStats(selectedRow, selectedCol);
             }
         }
     }
@@ -491,6 +837,7 @@ void DoMovement() {
 }
 
 void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mode) { 
+	frameAllocations.MarkStateChange();
 	if (GLFW_KEY_ESCAPE == key && GLFW_PRESS == action) {
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
@@ -505,11 +852,36 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mode
 			if (key == GLFW_KEY_2) {
 				useSideCamera = true;   // Cámara lateral
 			}
+			// Mostrar u ocultar las mejores líneas del análisis
+			if (key == GLFW_KEY_M) {
+				analysisEnabled = !analysisEnabled;
+				analysedKey = 0;
+				if (!analysisEnabled) {
+					liveAnalysis.Stop();
+					analysisOverlay.Clear();
+				}
+			}
 		}
 		else if (action == GLFW_RELEASE) {
 			keys[key] = false;
 		}
 	}
+
+	// Navegación de la partida reproducida (también al mantener la tecla)
+	if (replayMode && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+		if (key == GLFW_KEY_PERIOD) {
+			SeekReplay(replayPly + 1);
+		}
+		if (key == GLFW_KEY_COMMA) {
+			SeekReplay(replayPly - 1);
+		}
+		if (key == GLFW_KEY_HOME) {
+			SeekReplay(0);
+		}
+		if (key == GLFW_KEY_END) {
+			SeekReplay(replayTimeline.PlyCount());
+		}
+	}
 }
 
 /**
@@ -534,146 +906,18 @@ void MouseCallback(GLFWwindow* window, double xPos, double yPos)
 	lastX = xPos;
 	lastY = yPos;
 
-	camera.ProcessMouseMovement(xOffset, yOffset);
-}
-
-
-// --- Anadido: Funcion auxiliar para verificar caminos ---
-// Verifica si el camino entre (startRow, startCol) y (endRow, endCol) esta vacio.
-// NO verifica la validez del movimiento en si (horizontal, vertical, diagonal)
-// Asume que el movimiento es en linea recta (horizontal, vertical o diagonal perfecta).
-// No chequea la casilla final (endRow, endCol), solo las intermedias.
-bool IsPathClear(int startRow, int startCol, int endRow, int endCol) {
-	// Determinar la direcci�n del movimiento (paso en x, paso en y)
-	int stepY = (endRow > startRow) ? 1 : ((endRow < startRow) ? -1 : 0);
-	int stepX = (endCol > startCol) ? 1 : ((endCol < startCol) ? -1 : 0);
-
-	// Casilla actual empieza una despu�s del inicio
-	int currentRow = startRow + stepY;
-	int currentCol = startCol + stepX;
-
-	// Recorrer el camino hasta llegar a la casilla final
-	while (currentRow != endRow || currentCol != endCol) {
-		// Si alguna casilla intermedia no est� vac�a, el camino est� bloqueado
-		if (currentRow < 0 || currentRow >= 8 || currentCol < 0 || currentCol >= 8) {
-			// Seguridad: Si por alg�n error el c�lculo sale del tablero
-			std::cerr << "Error en IsPathClear: fuera de l�mites (" << currentRow << "," << currentCol << ")" << std::endl;
-			return false;
-		}
-		if (board[currentRow][currentCol].type != EMPTY) {
-			return false; // Camino bloqueado
+	// Recorrer la reproducción: la posición X del cursor elige la jugada
+	if (replayDragging) {
+		int windowWidth, windowHeight;
+		glfwGetWindowSize(window, &windowWidth, &windowHeight);
+		if (windowWidth > 0) {
+			double fraction = glm::clamp(xPos / windowWidth, 0.0, 1.0);
+			SeekReplay((int)std::lround(fraction * replayTimeline.PlyCount()));
 		}
-		// Avanzar a la siguiente casilla en el camino
-		currentRow += stepY;
-		currentCol += stepX;
+		return;
 	}
 
-	// Si el bucle termina, significa que todas las casillas intermedias estaban vacias
-	return true; // Camino despejado
-}
-
-
-// --- ACTUALIZADA: Validacion de Movimientos de Ajedrez (Reglas B�sicas) ---
-bool IsValidMove(ChessPiece* piece, int targetRow, int targetCol) {
-	// 1. Chequeos Iniciales Basicos
-	if (!piece || piece->type == EMPTY) {
-		std::cerr << "Error IsValidMove: Pieza inv�lida o vac�a." << std::endl;
-		return false;
-	}
-	if (targetRow < 0 || targetRow >= 8 || targetCol < 0 || targetCol >= 8) {
-		// std::cout << "Movimiento invalido: Fuera del tablero." << std::endl; // Mucho spam
-		return false; // Fuera del tablero
-	}
-
-	ChessPiece& targetSquare = board[targetRow][targetCol];
-	int startRow = piece->row;
-	int startCol = piece->col;
-
-	// No puedes mover a la misma casilla
-	if (startRow == targetRow && startCol == targetCol) {
-		return false;
-	}
-
-	// No puedes capturar una pieza de tu propio color
-	if (targetSquare.type != EMPTY && targetSquare.color == piece->color) {
-		// std::cout << "Movimiento invalido: No puedes capturar tu propia pieza." << std::endl;
-		return false;
-	}
-
-	// 2. Logica Especifica por Tipo de Pieza
-	switch (piece->type) {
-	case PAWN: {
-		int forward = (piece->color == WHITE) ? 1 : -1; // Direccion de avance
-		// Mover 1 casilla adelante
-		if (targetCol == startCol && targetRow == startRow + forward && targetSquare.type == EMPTY) {
-			return true;
-		}
-		// Mover 2 casillas adelante (solo desde posicion inicial)
-		bool isStartingRow = (piece->color == WHITE && startRow == 1) || (piece->color == BLACK && startRow == 6);
-		if (isStartingRow && targetCol == startCol && targetRow == startRow + 2 * forward && targetSquare.type == EMPTY) {
-			// Verificar que la casilla intermedia tambien esta vacia
-			if (board[startRow + forward][startCol].type == EMPTY) {
-				return true;
-			}
-		}
-		// Captura diagonal
-		if (std::abs(targetCol - startCol) == 1 && targetRow == startRow + forward && targetSquare.type != EMPTY && targetSquare.color != piece->color) {
-			return true;
-		}
-		// Faltan: En Passant, Promocion
-		return false; // Si no es ninguno de los anteriores, es invalido para el peon
-	}
-
-	case ROOK: {
-		// Debe ser movimiento horizontal o vertical
-		if (startRow != targetRow && startCol != targetCol) {
-			return false; // No es movimiento de torre
-		}
-		// Verificar que el camino esta despejado
-		return IsPathClear(startRow, startCol, targetRow, targetCol);
-	}
-
-	case KNIGHT: {
-		int dRow = std::abs(targetRow - startRow);
-		int dCol = std::abs(targetCol - startCol);
-		// Movimiento en 'L' (2 en una direccion, 1 en la perpendicular)
-		return (dRow == 2 && dCol == 1) || (dRow == 1 && dCol == 2);
-		// El caballo salta, no necesita IsPathClear
-	}
-
-	case BISHOP: {
-		// Debe ser movimiento diagonal
-		if (std::abs(targetRow - startRow) != std::abs(targetCol - startCol)) {
-			return false; // No es movimiento de alfil
-		}
-		// Verificar que el camino esta despejado
-		return IsPathClear(startRow, startCol, targetRow, targetCol);
-	}
-
-	case QUEEN: {
-		// Debe ser movimiento horizontal, vertical o diagonal
-		bool isStraight = (startRow == targetRow || startCol == targetCol);
-		bool isDiagonal = (std::abs(targetRow - startRow) == std::abs(targetCol - startCol));
-		if (!isStraight && !isDiagonal) {
-			return false; // No es movimiento de reina
-		}
-		// Verificar que el camino esta despejado
-		return IsPathClear(startRow, startCol, targetRow, targetCol);
-	}
-
-	case KING: {
-		int dRow = std::abs(targetRow - startRow);
-		int dCol = std::abs(targetCol - startCol);
-		// Mover solo 1 casilla en cualquier direccion
-		// Faltan: Enroque, Chequeo de Jaque
-		return dRow <= 1 && dCol <= 1;
-	}
-
-	case EMPTY:
-	default:
-		std::cerr << "Error IsValidMove: Tipo de pieza desconocido o EMPTY." << std::endl;
-		return false;
-	}
+	camera.ProcessMouseMovement(xOffset, yOffset);
 }
 
 
@@ -866,8 +1110,188 @@ void InitializeBoard(
 		for (int c = 0; c < 8; ++c) {
 			board[r][c].row = r;
 			board[r][c].col = c;
+			// Guardar la apariencia de cada tipo de pieza para ApplyPieceStyle
+			if (board[r][c].type != EMPTY) {
+				pieceStyles[board[r][c].color][board[r][c].type] = board[r][c];
+			}
+		}
+	}
+	pieceTransforms.InvalidateAll();
+}
+
+void ApplyPieceStyle(ChessPiece& piece) {
+	const ChessPiece& style = pieceStyles[piece.color][piece.type];
+	piece.model = style.model;
+	piece.positionOffset = style.positionOffset;
+	piece.scale = style.scale;
+	piece.rotationY = style.rotationY;
+}
+
+bool PieceStylesHaveUniformScale() {
+	for (int color = WHITE; color <= BLACK; ++color) {
+		for (int type = PAWN; type <= KING; ++type) {
+			glm::vec3 scale = glm::abs(pieceStyles[color][type].scale);
+			if (scale.x != scale.y || scale.y != scale.z) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Copia una posición al tablero de la ventana y reconstruye las listas de capturadas
+// comparando con las piezas de la posición inicial.
+void ShowPosition(const Position& pos) {
+	frameAllocations.MarkStateChange();
+	const int startingCount[7] = { 0, 8, 2, 2, 2, 1, 1 }; // EMPTY, PAWN, ROOK, KNIGHT, BISHOP, QUEEN, KING
+	int onBoard[3][7] = {};
+
+	for (int r = 0; r < 8; ++r) {
+		for (int c = 0; c < 8; ++c) {
+			board[r][c] = pos.board[r][c];
+			board[r][c].row = r;
+			board[r][c].col = c;
+			board[r][c].isSelected = false;
+			board[r][c].isMoving = false;
+			if (board[r][c].type != EMPTY) {
+				ApplyPieceStyle(board[r][c]);
+				onBoard[board[r][c].color][board[r][c].type]++;
+			}
+		}
+	}
+
+	whiteCapturedPieces.clear();
+	blackCapturedPieces.clear();
+	for (int color = WHITE; color <= BLACK; ++color) {
+		for (int type = PAWN; type <= KING; ++type) {
+			for (int i = onBoard[color][type]; i < startingCount[type]; ++i) {
+				ChessPiece captured;
+				captured.type = (PieceType)type;
+				captured.color = (PieceColor)color;
+				ApplyPieceStyle(captured);
+				(color == WHITE ? whiteCapturedPieces : blackCapturedPieces).push_back(captured);
+			}
+		}
+	}
+	whiteCapturedCount = (int)whiteCapturedPieces.size();
+	blackCapturedCount = (int)blackCapturedPieces.size();
+	pieceTransforms.InvalidateAll();
+
+	selectedPiece = nullptr;
+	selectedRow = -1;
+	selectedCol = -1;
+	currentPlayer = pos.sideToMove;
+	castlingRights = pos.castling;
+	enPassantCol = pos.enPassantCol;
+}
+
+Position CurrentPosition() {
+	Position pos;
+	for (int r = 0; r < 8; ++r) {
+		for (int c = 0; c < 8; ++c) {
+			pos.board[r][c] = board[r][c];
+		}
+	}
+	pos.sideToMove = currentPlayer;
+	pos.castling = castlingRights;
+	pos.enPassantCol = enPassantCol;
+	return pos;
+}
+
+void ShowOpeningStats(int row, int col) {
+	boardOverlay.Clear();
+	if (!openingBook.IsOpen() || row < 0 || col < 0) {
+		return;
+	}
+
+	std::vector<OpeningIndexEntry> entries;
+	openingBook.Probe(PositionKey(CurrentPosition()), entries);
+	for (const OpeningIndexEntry& entry : entries) {
+		ChessMove move = UnpackMove(entry.move);
+		if (move.fromRow != row || move.fromCol != col) {
+			continue;
+		}
+		// Puntuación para el jugador que mueve: 1 = siempre gana, 0 = siempre pierde
+		float games = (float)(entry.whiteWins + entry.draws + entry.blackWins);
+		float wins = (float)((currentPlayer == WHITE) ? entry.whiteWins : entry.blackWins);
+		float score = (wins + 0.5f * entry.draws) / games;
+		glm::vec3 color = glm::mix(glm::vec3(0.9f, 0.1f, 0.1f), glm::vec3(0.1f, 0.9f, 0.1f), score);
+		glm::vec3 center = GetWorldCoordinates(move.toRow, move.toCol);
+		center.y += 0.1f; // Apenas sobre el plano de las piezas
+		boardOverlay.AddSquare(center, TILE_SIZE * 0.8f, color);
+
+		std::cout << "Libro: " << (char)('a' + move.toCol) << (move.toRow + 1) << "  partidas: " << (int)games
+			<< "  +" << entry.whiteWins << " =" << entry.draws << " -" << entry.blackWins << std::endl;
+	}
+}
+
+bool LoadArchivedGame(const std::string& path, uint32_t gameIndex) {
+	ArchivedGame game;
+	if (!replayArchive.Open(path) || !replayArchive.ReadGame(gameIndex, game)) {
+		return false;
+	}
+	for (const auto& tag : game.tags) {
+		std::cout << tag.first << ": " << tag.second << std::endl;
+	}
+	std::cout << "Jugadas: " << game.moves.size()
+		<< "  (',' atras, '.' adelante, Inicio/Fin, arrastrar con el boton derecho para recorrer)" << std::endl;
+	replayTimeline.Load(game.start, game.moves);
+	replayMode = true;
+	replayPly = -1;
+	SeekReplay(0);
+	return true;
+}
+
+void SeekReplay(int ply) {
+	if (ply < 0 || ply > replayTimeline.PlyCount() || ply == replayPly) {
+		return;
+	}
+	// Saltos seguidos más rápidos que REPLAY_SCRUB_INTERVAL (o de más de una jugada) no se animan
+	double now = glfwGetTime();
+	bool stepForward = (ply > 0 && ply == replayPly + 1);
+	replayScrubbing = !stepForward || (now - lastSeekTime) < REPLAY_SCRUB_INTERVAL;
+	lastSeekTime = now;
+	replayPly = ply;
+
+	Position pos;
+	replayTimeline.PositionAt(ply, pos);
+	ShowPosition(pos);
+
+	// Un paso hacia adelante se anima igual que un movimiento del jugador
+	if (stepForward && !replayScrubbing) {
+		const ChessMove& move = replayTimeline.MoveAt(ply - 1);
+		ChessPiece& movingPiece = board[move.toRow][move.toCol];
+		movingPiece.isMoving = true;
+		movingPiece.startPos = GetWorldCoordinates(move.fromRow, move.fromCol);
+		movingPiece.targetPos = GetWorldCoordinates(move.toRow, move.toCol);
+		movingPiece.moveProgress = 0.0f;
+		// En el enroque también se anima la torre
+		if (movingPiece.type == KING && std::abs(move.toCol - move.fromCol) == 2) {
+			bool kingSide = move.toCol > move.fromCol;
+			ChessPiece& rook = board[move.toRow][kingSide ? 5 : 3];
+			rook.isMoving = true;
+			rook.startPos = GetWorldCoordinates(move.toRow, kingSide ? 7 : 0);
+			rook.targetPos = GetWorldCoordinates(move.toRow, kingSide ? 5 : 3);
+			rook.moveProgress = 0.0f;
 		}
 	}
+
+	// Barra de progreso detrás de la primera fila del tablero
+	float barLength = TILE_SIZE * 8.0f;
+	float progress = (replayTimeline.PlyCount() > 0) ? (float)ply / replayTimeline.PlyCount() : 0.0f;
+	glm::vec3 barStart(BOARD_OFFSET_X, PIECE_Y_OFFSET + 0.1f, BOARD_OFFSET_Z - TILE_SIZE * 0.6f);
+	replayOverlay.Clear();
+	replayOverlay.AddRect(barStart + glm::vec3(barLength * 0.5f, 0.0f, 0.0f), barLength, TILE_SIZE * 0.2f, glm::vec3(0.2f));
+	if (progress > 0.0f) {
+		replayOverlay.AddRect(barStart + glm::vec3(barLength * progress * 0.5f, 0.05f, 0.0f), barLength * progress, TILE_SIZE * 0.2f, glm::vec3(0.1f, 0.8f, 0.2f));
+	}
+}
+
+// Las capturadas de cada color se alinean a un costado del tablero, media casilla entre cada una
+glm::vec3 GetCapturedCoordinates(PieceColor color, size_t index) {
+	float worldX = (color == WHITE) ? CAPTURED_WHITE_X : CAPTURED_BLACK_X;
+	float worldZ = CAPTURED_Z_START + index * TILE_SIZE * 0.5f;
+	return glm::vec3(worldX, CAPTURED_Y, worldZ);
 }
 
 // --- Anadido: Funcion para obtener coordenadas del mundo desde fila/columna ---
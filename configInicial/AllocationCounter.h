@@ -0,0 +1,120 @@
+#pragma once
+
+// Contador de reservas de memoria dinámica por hilo.
+// Reemplaza los operator new/delete globales del programa para contar cada reserva en el
+// hilo que la hace. Con él, el ciclo de render comprueba que un cuadro no reserva memoria:
+// solo cuentan las reservas del hilo de la ventana, no las de los hilos del motor.
+//
+// Define funciones globales sin inline: debe incluirse en un solo .cpp (Ajedrez.cpp).
+
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+
+// Reservas hechas por el hilo actual desde que empezó
+inline uint64_t& ThreadAllocationCount()
+{
+	static thread_local uint64_t count = 0;
+	return count;
+}
+
+void* operator new(std::size_t size)
+{
+	ThreadAllocationCount()++;
+	void* memory = std::malloc(size > 0 ? size : 1);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	ThreadAllocationCount()++;
+	return std::malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+// Reservas hechas por el ciclo de render completo (eventos, animación, motor, análisis y
+// dibujo), acumuladas cuadro por cuadro. Los primeros WARMUP_FRAMES cuadros llenan las
+// capacidades de los búferes y no se cuentan; tampoco los cuadros marcados con
+// MarkStateChange (un movimiento, una tecla, un clic), que sí pueden reservar. Cualquier
+// otro cuadro que reserve es un error.
+struct FrameAllocationStats
+{
+	static const uint64_t WARMUP_FRAMES = 120;
+
+	uint64_t frames = 0;
+	uint64_t steadyFrames = 0;			// Cuadros contados: después del calentamiento y sin cambios de estado
+	uint64_t allocatingFrames = 0;		// Cuadros contados en los que se reservó algo
+	uint64_t allocations = 0;
+	uint64_t frameStart = 0;
+	bool stateChanged = false;
+
+	void BeginFrame()
+	{
+		this->frameStart = ThreadAllocationCount();
+		this->stateChanged = false;
+	}
+
+	// El cuadro actual cambió la partida o respondió a la entrada: sus reservas no cuentan
+	void MarkStateChange()
+	{
+		this->stateChanged = true;
+	}
+
+	// Devuelve las reservas del cuadro si es un cuadro contado que reservó, 0 si no
+	uint64_t EndFrame()
+	{
+		uint64_t allocated = ThreadAllocationCount() - this->frameStart;
+		this->frames++;
+		if (this->frames <= WARMUP_FRAMES || this->stateChanged)
+		{
+			return 0;
+		}
+		this->steadyFrames++;
+		this->allocations += allocated;
+		this->allocatingFrames += (allocated > 0) ? 1 : 0;
+		return allocated;
+	}
+};
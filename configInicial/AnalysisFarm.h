@@ -0,0 +1,263 @@
+#pragma once
+
+// Granja de análisis con varios procesos para corpus grandes (por ejemplo, una noche completa).
+//
+// El coordinador parte el archivo EPD en trabajos de FARM_JOB_SIZE posiciones y los deja en
+// una cola local de archivos junto al archivo de salida:
+//   salida.farm.<n>.pending   trabajo esperando
+//   salida.farm.<n>.w<id>     trabajo tomado por el proceso <id>
+//   salida.farm.<n>.out       resultado terminado
+//   salida.farm.<n>.failed    trabajo descartado después de FARM_MAX_ATTEMPTS intentos
+// Cada proceso trabajador es este mismo ejecutable con --farm-worker. Toma un trabajo
+// renombrando su archivo .pending (el renombrado solo le sale bien a un proceso), lo analiza
+// y publica el resultado con otro renombrado, así que nunca queda un .out a medias.
+//
+// Por cada trabajador el coordinador tiene un hilo que lo lanza y espera a que termine. Si el
+// proceso se cae, los trabajos que tenía tomados vuelven a la cola y se lanza otro proceso.
+// Al final los resultados se juntan en orden en el archivo de salida. Ningún proceso guarda
+// el corpus completo en memoria.
+//
+// Cada trabajador analiza las posiciones como --epd: con nodos > 0 busca cada una con su
+// propio Searcher (uno por proceso, que se reutiliza en todos sus trabajos), así que la
+// salida es la misma que la de --epd corpus.epd hilos nodos.
+//
+// Uso: configInicial.exe --farm corpus.epd resultados.txt [procesos] [nodos]
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "EpdSuite.h"
+
+const int FARM_JOB_SIZE = 4096;
+const int FARM_MAX_ATTEMPTS = 3;
+
+inline std::string FarmJobPath(const std::string& spool, int job, const std::string& state)
+{
+	return spool + "." + std::to_string(job) + "." + state;
+}
+
+inline bool FarmFileExists(const std::string& path)
+{
+	std::ifstream file(path);
+	return file.good();
+}
+
+// Analiza un trabajo tomado y publica su resultado. searcher es nullptr si solo se cuentan movimientos.
+inline bool RunFarmJob(const std::string& spool, int job, const std::string& claimed, int workerId,
+	Searcher* searcher, uint64_t nodeLimit)
+{
+	std::ifstream in(claimed);
+	std::string tmpPath = FarmJobPath(spool, job, "tmp" + std::to_string(workerId));
+	std::ofstream out(tmpPath);
+	if (!in || !out)
+	{
+		return false;
+	}
+
+	long long number = (long long)job * FARM_JOB_SIZE;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		out << ++number << "\t";
+		WriteEpdResult(out, AnalyzeEpdLine(line, searcher, nodeLimit));
+	}
+	out.close();
+	if (!out)
+	{
+		return false;
+	}
+	std::remove(FarmJobPath(spool, job, "out").c_str());
+	if (std::rename(tmpPath.c_str(), FarmJobPath(spool, job, "out").c_str()) != 0)
+	{
+		return false;
+	}
+	std::remove(claimed.c_str());
+	return true;
+}
+
+// Proceso trabajador: toma trabajos pendientes hasta que no quede ninguno
+inline int RunFarmWorker(const std::string& spool, int jobCount, int workerId, uint64_t nodeLimit)
+{
+	std::string suffix = "w" + std::to_string(workerId);
+	std::unique_ptr<Searcher> searcher;
+	if (nodeLimit > 0)
+	{
+		searcher.reset(new Searcher(EPD_SEARCH_MEGABYTES));
+	}
+	bool claimedAny = true;
+	while (claimedAny)
+	{
+		claimedAny = false;
+		for (int job = 0; job < jobCount; job++)
+		{
+			std::string claimed = FarmJobPath(spool, job, suffix);
+			if (std::rename(FarmJobPath(spool, job, "pending").c_str(), claimed.c_str()) != 0)
+			{
+				continue; // Ya lo tomó otro proceso, ya está hecho o falló
+			}
+			claimedAny = true;
+			if (!RunFarmJob(spool, job, claimed, workerId, searcher.get(), nodeLimit))
+			{
+				std::cerr << "ERROR::FARM::TRABAJO " << job << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+// Arma la línea de comandos para volver a lanzar este ejecutable como trabajador
+inline std::string FarmWorkerCommand(const std::string& exePath, const std::string& spool, int jobCount, int workerId,
+	uint64_t nodeLimit)
+{
+	std::string command = "\"" + exePath + "\" --farm-worker \"" + spool + "\" " +
+		std::to_string(jobCount) + " " + std::to_string(workerId) + " " + std::to_string(nodeLimit);
+#ifdef _WIN32
+	command = "\"" + command + "\""; // cmd /c quita las comillas exteriores
+#endif
+	return command;
+}
+
+inline int RunAnalysisFarm(const std::string& exePath, const std::string& inputPath, const std::string& outputPath, int numWorkers,
+	uint64_t nodeLimit)
+{
+	std::ifstream input(inputPath);
+	if (!input)
+	{
+		std::cerr << "ERROR::FARM::NO_SE_PUDO_ABRIR " << inputPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (numWorkers <= 0)
+	{
+		numWorkers = (int)std::thread::hardware_concurrency();
+		if (numWorkers <= 0)
+		{
+			numWorkers = 1;
+		}
+	}
+	auto start = std::chrono::steady_clock::now();
+	std::string spool = outputPath + ".farm";
+
+	// Partir la entrada en trabajos
+	int jobCount = 0;
+	long long positions = 0;
+	std::ofstream jobFile;
+	std::string line;
+	while (std::getline(input, line))
+	{
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+		{
+			continue;
+		}
+		if (positions % FARM_JOB_SIZE == 0)
+		{
+			jobFile.close();
+			std::remove(FarmJobPath(spool, jobCount, "out").c_str()); // Restos de una ejecución anterior
+			std::remove(FarmJobPath(spool, jobCount, "failed").c_str());
+			jobFile.open(FarmJobPath(spool, jobCount++, "pending"));
+			if (!jobFile)
+			{
+				std::cerr << "ERROR::FARM::NO_SE_PUDO_ESCRIBIR " << FarmJobPath(spool, jobCount - 1, "pending") << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		jobFile << line << "\n";
+		positions++;
+	}
+	jobFile.close();
+
+	// Un hilo por proceso trabajador; relanza el proceso mientras queden trabajos sin terminar
+	std::mutex mutex;
+	std::vector<int> attempts(jobCount, 0);
+	std::atomic<int> launches(0), restarts(0), failedJobs(0);
+	auto pendingWork = [&]() {
+		for (int job = 0; job < jobCount; job++)
+		{
+			if (FarmFileExists(FarmJobPath(spool, job, "pending")))
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+
+	std::vector<std::thread> supervisors;
+	for (int id = 0; id < numWorkers; id++)
+	{
+		supervisors.emplace_back([&, id]() {
+			std::string suffix = "w" + std::to_string(id);
+			while (pendingWork())
+			{
+				launches++;
+				int status = std::system(FarmWorkerCommand(exePath, spool, jobCount, id, nodeLimit).c_str());
+				if (status != 0)
+				{
+					restarts++;
+					std::cerr << "Trabajador " << id << " termino con codigo " << status << ", se relanza" << std::endl;
+				}
+
+				// Los trabajos que el proceso dejó tomados vuelven a la cola
+				std::lock_guard<std::mutex> lock(mutex);
+				for (int job = 0; job < jobCount; job++)
+				{
+					std::string claimed = FarmJobPath(spool, job, suffix);
+					if (!FarmFileExists(claimed))
+					{
+						continue;
+					}
+					std::remove(FarmJobPath(spool, job, "tmp" + std::to_string(id)).c_str());
+					bool giveUp = ++attempts[job] >= FARM_MAX_ATTEMPTS;
+					std::rename(claimed.c_str(), FarmJobPath(spool, job, giveUp ? "failed" : "pending").c_str());
+					failedJobs += giveUp ? 1 : 0;
+				}
+			}
+		});
+	}
+	for (std::thread& supervisor : supervisors)
+	{
+		supervisor.join();
+	}
+
+	// Juntar los resultados en orden
+	std::ofstream output(outputPath);
+	if (!output)
+	{
+		std::cerr << "ERROR::FARM::NO_SE_PUDO_ESCRIBIR " << outputPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	for (int job = 0; job < jobCount; job++)
+	{
+		std::string resultPath = FarmJobPath(spool, job, "out");
+		std::ifstream result(resultPath);
+		if (result)
+		{
+			output << result.rdbuf();
+			result.close();
+			std::remove(resultPath.c_str());
+		}
+		else
+		{
+			output << "# trabajo " << job << " fallido (posiciones " << (long long)job * FARM_JOB_SIZE + 1
+				<< " a " << (long long)(job + 1) * FARM_JOB_SIZE << ")" << std::endl;
+			std::remove(FarmJobPath(spool, job, "failed").c_str());
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cerr << "Posiciones: " << positions << "  trabajos: " << jobCount << "  fallidos: " << failedJobs
+		<< "  procesos lanzados: " << launches << "  reinicios: " << restarts << std::endl;
+	std::cerr << "Tiempo: " << std::fixed << std::setprecision(3) << seconds << " s  ("
+		<< std::setprecision(0) << (seconds > 0.0 ? positions / seconds : 0.0) << " posiciones/s, "
+		<< numWorkers << " procesos)" << std::endl;
+	return failedJobs == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+// Marcas de color dibujadas sobre las casillas del tablero (estadísticas del explorador
+// de aperturas, flechas del análisis, etc.). Se dibujan con Shader/core.vs y Shader/core.frag,
+// que pintan la geometría de un solo color.
+
+#include <vector>
+#include <cmath>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Shader.h"
+#include "GLStateCache.h"
+
+class BoardOverlay
+{
+public:
+	// Crea el cuadrado unitario y la punta de flecha en el plano XZ. Requiere un contexto de OpenGL activo.
+	// markerCapacity reserva lugar para esa cantidad de marcas (una flecha son dos), de modo
+	// que agregarlas durante el ciclo de render no reserve memoria.
+	void Init(size_t markerCapacity = 0)
+	{
+		this->markers.reserve(markerCapacity);
+		GLfloat vertices[] = {
+			// Cuadrado centrado en el origen (vértices 0 a 5)
+			-0.5f, 0.0f, -0.5f,
+			 0.5f, 0.0f, -0.5f,
+			 0.5f, 0.0f,  0.5f,
+			-0.5f, 0.0f, -0.5f,
+			 0.5f, 0.0f,  0.5f,
+			-0.5f, 0.0f,  0.5f,
+			// Triángulo con la base en z = 0 y la punta en z = 1 (vértices 6 a 8)
+			-0.5f, 0.0f,  0.0f,
+			 0.5f, 0.0f,  0.0f,
+			 0.0f, 0.0f,  1.0f
+		};
+		glGenVertexArrays(1, &this->VAO);
+		glGenBuffers(1, &this->VBO);
+		GLState().BindVertexArray(this->VAO);
+		GLState().BindBuffer(GL_ARRAY_BUFFER, this->VBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+		GLState().BindVertexArray(0);
+	}
+
+	void Clear()
+	{
+		this->markers.clear();
+	}
+
+	// Agrega un cuadrado de color con centro en center (en coordenadas del mundo)
+	void AddSquare(glm::vec3 center, float size, glm::vec3 color)
+	{
+		this->AddRect(center, size, size, color);
+	}
+
+	// Agrega un rectángulo de color de sizeX por sizeZ unidades
+	void AddRect(glm::vec3 center, float sizeX, float sizeZ, glm::vec3 color)
+	{
+		Marker marker;
+		marker.transform = glm::scale(glm::translate(glm::mat4(1.0f), center), glm::vec3(sizeX, 1.0f, sizeZ));
+		marker.color = color;
+		marker.firstVertex = 0;
+		marker.vertexCount = 6;
+		this->markers.push_back(marker);
+	}
+
+	// Agrega una flecha de from a to (a la misma altura) con un cuerpo de ancho width
+	void AddArrow(glm::vec3 from, glm::vec3 to, float width, glm::vec3 color)
+	{
+		glm::vec3 direction = to - from;
+		float length = glm::length(direction);
+		if (length <= 0.0f)
+		{
+			return;
+		}
+		direction /= length;
+		float headLength = glm::min(width * 2.5f, length * 0.5f);
+		float bodyLength = length - headLength;
+		// Girar en Y lleva el eje +Z a (sin a, 0, cos a)
+		glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), std::atan2(direction.x, direction.z), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		Marker body;
+		body.transform = glm::translate(glm::mat4(1.0f), from + direction * (bodyLength * 0.5f)) * rotation *
+			glm::scale(glm::mat4(1.0f), glm::vec3(width, 1.0f, bodyLength));
+		body.color = color;
+		body.firstVertex = 0;
+		body.vertexCount = 6;
+		this->markers.push_back(body);
+
+		Marker head;
+		head.transform = glm::translate(glm::mat4(1.0f), from + direction * bodyLength) * rotation *
+			glm::scale(glm::mat4(1.0f), glm::vec3(width * 2.5f, 1.0f, headLength));
+		head.color = color;
+		head.firstVertex = 6;
+		head.vertexCount = 3;
+		this->markers.push_back(head);
+	}
+
+	bool Empty() const
+	{
+		return this->markers.empty();
+	}
+
+	// La cámara llega por el bloque FrameData (FrameUniforms.h)
+	void Draw(const Shader& shader)
+	{
+		if (this->markers.empty())
+		{
+			return;
+		}
+		shader.Use();
+		if (shader.Program != this->locationProgram)
+		{
+			// Las localidades se buscan solo la primera vez que se dibuja con este programa
+			this->locationProgram = shader.Program;
+			this->modelLoc = shader.GetUniformLocation("model");
+			this->colorLoc = shader.GetUniformLocation("color");
+		}
+
+		GLState().BindVertexArray(this->VAO);
+		for (const Marker& marker : this->markers)
+		{
+			shader.SetMat4(this->modelLoc, marker.transform);
+			shader.SetVec3(this->colorLoc, marker.color);
+			glDrawArrays(GL_TRIANGLES, marker.firstVertex, marker.vertexCount);
+		}
+	}
+
+private:
+	struct Marker
+	{
+		glm::mat4 transform;
+		glm::vec3 color;
+		GLint firstVertex;
+		GLsizei vertexCount;
+	};
+
+	GLuint VAO = 0, VBO = 0;
+	std::vector<Marker> markers;
+	GLuint locationProgram = 0;		// Programa al que pertenecen modelLoc y colorLoc
+	GLint modelLoc = -1;
+	GLint colorLoc = -1;
+};
@@ -0,0 +1,718 @@
+#pragma once
+
+// Reglas del ajedrez independientes de la ventana y del render.
+// Todo lo que está aquí trabaja sobre un tablero pasado por parámetro, de modo que
+// las herramientas de línea de comandos puedan validar muchas posiciones a la vez
+// (una copia del tablero por hilo) sin tocar la partida que se muestra en pantalla.
+//
+// GenerateMoves da solo jugadas legales: incluye el enroque y la captura al paso y descarta
+// las que dejan al rey propio en jaque. Una partida termina cuando el bando que mueve no
+// tiene jugadas: mate si está en jaque (IsInCheck), ahogado si no.
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+class Model;
+
+// Tipos de Pieza de Ajedrez
+enum PieceType { EMPTY, PAWN, ROOK, KNIGHT, BISHOP, QUEEN, KING };
+// Colores de Pieza de Ajedrez
+enum PieceColor { NONE, WHITE, BLACK }; // NONE se usa para casillas vacías o piezas capturadas
+
+// Estructura para representar una Pieza de Ajedrez en el tablero
+struct ChessPiece {
+    PieceType type = EMPTY;         // Tipo de la pieza (Peón, Torre, etc.)
+    PieceColor color = NONE;        // Color de la pieza (Blanco, Negro)
+    Model* model = nullptr;         // Puntero al modelo 3D que representa la pieza
+    int row = -1;                   // Fila actual de la pieza en el tablero (0-7)
+    int col = -1;                   // Columna actual de la pieza en el tablero (0-7)
+    glm::vec3 positionOffset = glm::vec3(0.0f); // Desplazamiento visual para ajustar el modelo
+    glm::vec3 scale = glm::vec3(1.0f);          // Escala del modelo
+    float rotationY = 0.0f;         // Rotación en el eje Y (en radianes) para orientar el modelo
+    bool isSelected = false;        // true si la pieza está actualmente seleccionada por el jugador
+
+    // Para animación
+    bool isMoving = false;
+    glm::vec3 startPos;
+    glm::vec3 targetPos;
+    float moveProgress = 0.0f;
+    float moveSpeed = 0.2f; // Velocidad de la animación (ajustable)
+};
+
+// Tablero 8x8: fila 0 es la primera fila de las blancas, columna 0 es la columna 'a'
+typedef ChessPiece Board[8][8];
+
+// Derechos de enroque (bits de Position::castling)
+const uint8_t CASTLE_WHITE_KING = 1;	// O-O de las blancas
+const uint8_t CASTLE_WHITE_QUEEN = 2;	// O-O-O de las blancas
+const uint8_t CASTLE_BLACK_KING = 4;
+const uint8_t CASTLE_BLACK_QUEEN = 8;
+const uint8_t CASTLE_ALL = 15;
+
+// Posición completa: tablero, jugador al que le toca mover, derechos de enroque y la
+// columna en la que se puede capturar al paso
+struct Position {
+	Board board;
+	PieceColor sideToMove = WHITE;
+	uint8_t castling = 0;		// Combinación de CASTLE_*
+	int enPassantCol = -1;		// Columna del peón que acaba de avanzar dos casillas, -1 si no hay
+};
+
+// Movimiento de una casilla a otra. promotion vale EMPTY si el movimiento no corona.
+struct ChessMove {
+	int fromRow = -1;
+	int fromCol = -1;
+	int toRow = -1;
+	int toCol = -1;
+	PieceType promotion = EMPTY;
+
+	bool operator==(const ChessMove& other) const {
+		return fromRow == other.fromRow && fromCol == other.fromCol &&
+			toRow == other.toRow && toCol == other.toCol && promotion == other.promotion;
+	}
+};
+
+// Lo necesario para deshacer un movimiento hecho con MakeMove
+struct MoveUndo {
+	ChessPiece moved;
+	ChessPiece captured;		// En la captura al paso, el peón capturado
+	uint8_t castling = 0;
+	int enPassantCol = -1;
+};
+
+const char* const START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+inline PieceColor Opponent(PieceColor color) {
+	return (color == WHITE) ? BLACK : WHITE;
+}
+
+// Saltos del caballo y pasos del rey (filas, columnas). Los cuatro primeros pasos del rey son
+// rectos y los cuatro últimos diagonales: son también las direcciones de torre y alfil.
+const int KNIGHT_OFFSETS[8][2] = { { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 } };
+const int KING_OFFSETS[8][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }, { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+
+inline bool IsOnBoard(int row, int col) {
+	return row >= 0 && row < 8 && col >= 0 && col < 8;
+}
+
+// ¿Alguna pieza de color by ataca la casilla (row, col)?
+inline bool IsSquareAttacked(const Board& board, int row, int col, PieceColor by) {
+	// Un peón ataca en diagonal hacia adelante: se busca una fila "atrás" de la casilla
+	int pawnRow = row - ((by == WHITE) ? 1 : -1);
+	for (int side = -1; side <= 1; side += 2) {
+		if (IsOnBoard(pawnRow, col + side)) {
+			const ChessPiece& piece = board[pawnRow][col + side];
+			if (piece.type == PAWN && piece.color == by) {
+				return true;
+			}
+		}
+	}
+	for (int i = 0; i < 8; ++i) {
+		int r = row + KNIGHT_OFFSETS[i][0];
+		int c = col + KNIGHT_OFFSETS[i][1];
+		if (IsOnBoard(r, c) && board[r][c].type == KNIGHT && board[r][c].color == by) {
+			return true;
+		}
+		r = row + KING_OFFSETS[i][0];
+		c = col + KING_OFFSETS[i][1];
+		if (IsOnBoard(r, c) && board[r][c].type == KING && board[r][c].color == by) {
+			return true;
+		}
+	}
+	for (int i = 0; i < 8; ++i) {
+		PieceType slider = (i < 4) ? ROOK : BISHOP;
+		int r = row + KING_OFFSETS[i][0];
+		int c = col + KING_OFFSETS[i][1];
+		while (IsOnBoard(r, c)) {
+			const ChessPiece& piece = board[r][c];
+			if (piece.type != EMPTY) {
+				if (piece.color == by && (piece.type == slider || piece.type == QUEEN)) {
+					return true;
+				}
+				break;
+			}
+			r += KING_OFFSETS[i][0];
+			c += KING_OFFSETS[i][1];
+		}
+	}
+	return false;
+}
+
+// Busca el rey de color. Devuelve false si no hay (posiciones de prueba sin rey).
+inline bool FindKing(const Board& board, PieceColor color, int& row, int& col) {
+	for (int r = 0; r < 8; ++r) {
+		for (int c = 0; c < 8; ++c) {
+			if (board[r][c].type == KING && board[r][c].color == color) {
+				row = r;
+				col = c;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// ¿Está en jaque el rey del bando que mueve?
+inline bool IsInCheck(const Position& pos) {
+	int row, col;
+	return FindKing(pos.board, pos.sideToMove, row, col) && IsSquareAttacked(pos.board, row, col, Opponent(pos.sideToMove));
+}
+
+// Derechos de enroque que se pierden cuando algo sale de (o llega a) la casilla: la del rey
+// quita los dos enroques de su color y la de cada torre el de su lado
+inline uint8_t CastlingRightsAt(int row, int col) {
+	if (row != 0 && row != 7) {
+		return 0;
+	}
+	uint8_t kingSide = (row == 0) ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+	uint8_t queenSide = (row == 0) ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+	switch (col) {
+	case 0: return queenSide;
+	case 4: return (uint8_t)(kingSide | queenSide);
+	case 7: return kingSide;
+	default: return 0;
+	}
+}
+
+// El enroque se escribe como el movimiento del rey dos columnas hacia su torre
+inline bool IsCastlingMove(const Position& pos, const ChessMove& move) {
+	return pos.board[move.fromRow][move.fromCol].type == KING && std::abs(move.toCol - move.fromCol) == 2;
+}
+
+// Un peón que entra en diagonal a la casilla de paso (siempre vacía) captura al paso
+inline bool IsEnPassantMove(const Position& pos, const ChessMove& move) {
+	return pos.enPassantCol >= 0 && move.toCol == pos.enPassantCol && move.fromCol != move.toCol &&
+		move.toRow == ((pos.sideToMove == WHITE) ? 5 : 2) && pos.board[move.fromRow][move.fromCol].type == PAWN;
+}
+
+// Casillas a las que puede ir la pieza de (row, col) sin mirar si su rey queda en jaque.
+// Bit fila * 8 + columna de la casilla destino.
+inline uint64_t PieceTargets(const Position& pos, int row, int col) {
+	const ChessPiece& piece = pos.board[row][col];
+	uint64_t targets = 0;
+	auto add = [&](int r, int c) {
+		targets |= 1ull << (r * 8 + c);
+	};
+	// Casilla libre o con pieza rival
+	auto reachable = [&](int r, int c) {
+		return IsOnBoard(r, c) && (pos.board[r][c].type == EMPTY || pos.board[r][c].color != piece.color);
+	};
+
+	switch (piece.type) {
+	case PAWN: {
+		int forward = (piece.color == WHITE) ? 1 : -1;
+		int startRow = (piece.color == WHITE) ? 1 : 6;
+		int next = row + forward;
+		if (!IsOnBoard(next, col)) {
+			break;
+		}
+		if (pos.board[next][col].type == EMPTY) {
+			add(next, col);
+			if (row == startRow && pos.board[next + forward][col].type == EMPTY) {
+				add(next + forward, col);
+			}
+		}
+		int passantRow = (piece.color == WHITE) ? 5 : 2;
+		for (int side = -1; side <= 1; side += 2) {
+			int c = col + side;
+			if (!IsOnBoard(next, c)) {
+				continue;
+			}
+			const ChessPiece& target = pos.board[next][c];
+			if ((target.type != EMPTY && target.color != piece.color) ||
+				(piece.color == pos.sideToMove && next == passantRow && c == pos.enPassantCol)) {
+				add(next, c);
+			}
+		}
+		break;
+	}
+	case KNIGHT:
+		for (const int (&offset)[2] : KNIGHT_OFFSETS) {
+			if (reachable(row + offset[0], col + offset[1])) {
+				add(row + offset[0], col + offset[1]);
+			}
+		}
+		break;
+	case ROOK:
+	case BISHOP:
+	case QUEEN:
+		for (int i = 0; i < 8; ++i) {
+			if ((piece.type == ROOK && i >= 4) || (piece.type == BISHOP && i < 4)) {
+				continue;
+			}
+			int r = row + KING_OFFSETS[i][0];
+			int c = col + KING_OFFSETS[i][1];
+			while (reachable(r, c)) {
+				add(r, c);
+				if (pos.board[r][c].type != EMPTY) {
+					break; // Captura: no se sigue detrás de la pieza
+				}
+				r += KING_OFFSETS[i][0];
+				c += KING_OFFSETS[i][1];
+			}
+		}
+		break;
+	case KING: {
+		for (const int (&offset)[2] : KING_OFFSETS) {
+			if (reachable(row + offset[0], col + offset[1])) {
+				add(row + offset[0], col + offset[1]);
+			}
+		}
+		// Enroque: el rey no puede estar en jaque ni pasar por (o llegar a) una casilla atacada
+		int homeRow = (piece.color == WHITE) ? 0 : 7;
+		uint8_t kingSide = (piece.color == WHITE) ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+		uint8_t queenSide = (piece.color == WHITE) ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+		if (row != homeRow || col != 4 || (pos.castling & (kingSide | queenSide)) == 0) {
+			break;
+		}
+		PieceColor enemy = Opponent(piece.color);
+		if (IsSquareAttacked(pos.board, row, col, enemy)) {
+			break;
+		}
+		const Board& board = pos.board;
+		auto ownRook = [&](int c) {
+			return board[row][c].type == ROOK && board[row][c].color == piece.color;
+		};
+		if ((pos.castling & kingSide) && ownRook(7) && board[row][5].type == EMPTY && board[row][6].type == EMPTY &&
+			!IsSquareAttacked(board, row, 5, enemy) && !IsSquareAttacked(board, row, 6, enemy)) {
+			add(row, 6);
+		}
+		if ((pos.castling & queenSide) && ownRook(0) && board[row][1].type == EMPTY && board[row][2].type == EMPTY &&
+			board[row][3].type == EMPTY && !IsSquareAttacked(board, row, 3, enemy) && !IsSquareAttacked(board, row, 2, enemy)) {
+			add(row, 2);
+		}
+		break;
+	}
+	case EMPTY:
+	default:
+		break;
+	}
+	return targets;
+}
+
+// Aplica un movimiento ya validado y cambia el turno. Guarda en undo lo necesario para deshacerlo.
+inline void MakeMove(Position& pos, const ChessMove& move, MoveUndo& undo) {
+	ChessPiece& from = pos.board[move.fromRow][move.fromCol];
+	ChessPiece& to = pos.board[move.toRow][move.toCol];
+	undo.moved = from;
+	undo.captured = to;
+	undo.castling = pos.castling;
+	undo.enPassantCol = pos.enPassantCol;
+
+	if (IsEnPassantMove(pos, move)) {
+		ChessPiece& passed = pos.board[move.fromRow][move.toCol];
+		undo.captured = passed;
+		passed = ChessPiece();
+		passed.row = move.fromRow;
+		passed.col = move.toCol;
+	}
+	if (IsCastlingMove(pos, move)) {
+		// La torre salta al otro lado del rey
+		int rookFrom = (move.toCol > move.fromCol) ? 7 : 0;
+		int rookTo = (move.toCol > move.fromCol) ? 5 : 3;
+		ChessPiece& rook = pos.board[move.fromRow][rookTo];
+		rook = pos.board[move.fromRow][rookFrom];
+		rook.col = rookTo;
+		pos.board[move.fromRow][rookFrom] = ChessPiece();
+		pos.board[move.fromRow][rookFrom].row = move.fromRow;
+		pos.board[move.fromRow][rookFrom].col = rookFrom;
+	}
+
+	to = from;
+	to.row = move.toRow;
+	to.col = move.toCol;
+	to.isSelected = false;
+	if (move.promotion != EMPTY) {
+		to.type = move.promotion;
+	}
+
+	from = ChessPiece();
+	from.row = move.fromRow;
+	from.col = move.fromCol;
+
+	pos.castling &= (uint8_t)~(CastlingRightsAt(move.fromRow, move.fromCol) | CastlingRightsAt(move.toRow, move.toCol));
+	pos.enPassantCol = (undo.moved.type == PAWN && std::abs(move.toRow - move.fromRow) == 2) ? move.fromCol : -1;
+	pos.sideToMove = Opponent(pos.sideToMove);
+}
+
+inline void UnmakeMove(Position& pos, const ChessMove& move, const MoveUndo& undo) {
+	pos.sideToMove = Opponent(pos.sideToMove);
+	pos.castling = undo.castling;
+	pos.enPassantCol = undo.enPassantCol;
+	pos.board[move.fromRow][move.fromCol] = undo.moved;
+
+	if (IsEnPassantMove(pos, move)) {
+		pos.board[move.toRow][move.toCol] = ChessPiece();
+		pos.board[move.toRow][move.toCol].row = move.toRow;
+		pos.board[move.toRow][move.toCol].col = move.toCol;
+		pos.board[move.fromRow][move.toCol] = undo.captured;
+		return;
+	}
+	pos.board[move.toRow][move.toCol] = undo.captured;
+	if (IsCastlingMove(pos, move)) {
+		int rookFrom = (move.toCol > move.fromCol) ? 7 : 0;
+		int rookTo = (move.toCol > move.fromCol) ? 5 : 3;
+		ChessPiece& rook = pos.board[move.fromRow][rookFrom];
+		rook = pos.board[move.fromRow][rookTo];
+		rook.col = rookFrom;
+		pos.board[move.fromRow][rookTo] = ChessPiece();
+		pos.board[move.fromRow][rookTo].row = move.fromRow;
+		pos.board[move.fromRow][rookTo].col = rookTo;
+	}
+}
+
+// Enumera las jugadas legales del jugador al que le toca.
+// El orden es estable (casilla de origen y luego de destino, de a1 a h8), así que el
+// índice de un movimiento dentro de la lista identifica ese movimiento en la posición.
+// Un peón que llega a la última fila genera una jugada por cada pieza de coronación.
+inline void GenerateMoves(const Position& pos, std::vector<ChessMove>& moves) {
+	moves.clear();
+	const PieceType promotions[] = { QUEEN, ROOK, BISHOP, KNIGHT };
+	PieceColor enemy = Opponent(pos.sideToMove);
+	int kingRow = -1, kingCol = -1;
+	bool hasKing = FindKing(pos.board, pos.sideToMove, kingRow, kingCol);
+	Position scratch = pos; // Cada jugada se prueba aquí para ver si deja al rey en jaque
+	MoveUndo undo;
+	for (int r = 0; r < 8; ++r) {
+		for (int c = 0; c < 8; ++c) {
+			const ChessPiece& piece = pos.board[r][c];
+			if (piece.type == EMPTY || piece.color != pos.sideToMove) {
+				continue;
+			}
+			int lastRow = (piece.color == WHITE) ? 7 : 0;
+			uint64_t targets = PieceTargets(pos, r, c);
+			for (int square = 0; targets != 0; ++square, targets >>= 1) {
+				if ((targets & 1) == 0) {
+					continue;
+				}
+				ChessMove move;
+				move.fromRow = r;
+				move.fromCol = c;
+				move.toRow = square / 8;
+				move.toCol = square % 8;
+				if (hasKing) {
+					MakeMove(scratch, move, undo);
+					bool legal = (piece.type == KING)
+						? !IsSquareAttacked(scratch.board, move.toRow, move.toCol, enemy)
+						: !IsSquareAttacked(scratch.board, kingRow, kingCol, enemy);
+					UnmakeMove(scratch, move, undo);
+					if (!legal) {
+						continue;
+					}
+				}
+				if (piece.type == PAWN && move.toRow == lastRow) {
+					for (PieceType promotion : promotions) {
+						move.promotion = promotion;
+						moves.push_back(move);
+					}
+				}
+				else {
+					moves.push_back(move);
+				}
+			}
+		}
+	}
+}
+
+// Movimiento en notación de coordenadas ("e2e4", "a7a8q")
+inline std::string MoveToString(const ChessMove& move) {
+	std::string text;
+	text += (char)('a' + move.fromCol);
+	text += (char)('1' + move.fromRow);
+	text += (char)('a' + move.toCol);
+	text += (char)('1' + move.toRow);
+	switch (move.promotion) {
+	case QUEEN: text += 'q'; break;
+	case ROOK: text += 'r'; break;
+	case BISHOP: text += 'b'; break;
+	case KNIGHT: text += 'n'; break;
+	default: break;
+	}
+	return text;
+}
+
+// Movimiento empaquetado en 16 bits: origen | destino << 6 | coronación << 12
+inline uint16_t PackMove(const ChessMove& move) {
+	return (uint16_t)((move.fromRow * 8 + move.fromCol) | ((move.toRow * 8 + move.toCol) << 6) | ((int)move.promotion << 12));
+}
+
+inline ChessMove UnpackMove(uint16_t packed) {
+	ChessMove move;
+	move.fromRow = (packed & 63) / 8;
+	move.fromCol = (packed & 63) % 8;
+	move.toRow = ((packed >> 6) & 63) / 8;
+	move.toCol = ((packed >> 6) & 63) % 8;
+	move.promotion = (PieceType)((packed >> 12) & 7);
+	return move;
+}
+
+// Deja todas las casillas vacías, cada una con su fila y columna
+inline void ClearBoard(Board& board) {
+	for (int r = 0; r < 8; ++r) {
+		for (int c = 0; c < 8; ++c) {
+			board[r][c] = ChessPiece();
+			board[r][c].row = r;
+			board[r][c].col = c;
+		}
+	}
+}
+
+// Carga una posición en notación FEN: tablero, turno, derechos de enroque y casilla de
+// captura al paso (los contadores de jugadas no se usan). Los campos de enroque y captura al
+// paso pueden faltar. Devuelve false si el texto no es un FEN válido.
+inline bool LoadFEN(Position& pos, const std::string& fen) {
+	std::istringstream fields(fen);
+	std::string placement, side, castling, enPassant;
+	if (!(fields >> placement >> side)) {
+		return false;
+	}
+	if (!(fields >> castling)) {
+		castling = "-";
+	}
+	if (!(fields >> enPassant)) {
+		enPassant = "-";
+	}
+
+	ClearBoard(pos.board);
+	int row = 7;
+	int col = 0;
+	for (char ch : placement) {
+		if (ch == '/') {
+			if (col != 8 || row == 0) {
+				return false;
+			}
+			--row;
+			col = 0;
+			continue;
+		}
+		if (ch >= '1' && ch <= '8') {
+			col += ch - '0';
+			if (col > 8) {
+				return false;
+			}
+			continue;
+		}
+
+		PieceType type;
+		switch (ch | 0x20) { // Minúscula
+		case 'p': type = PAWN; break;
+		case 'r': type = ROOK; break;
+		case 'n': type = KNIGHT; break;
+		case 'b': type = BISHOP; break;
+		case 'q': type = QUEEN; break;
+		case 'k': type = KING; break;
+		default: return false;
+		}
+		if (col >= 8) {
+			return false;
+		}
+		ChessPiece& piece = pos.board[row][col];
+		piece.type = type;
+		piece.color = (ch >= 'a') ? BLACK : WHITE;
+		++col;
+	}
+	if (row != 0 || col != 8) {
+		return false;
+	}
+
+	if (side == "w") {
+		pos.sideToMove = WHITE;
+	}
+	else if (side == "b") {
+		pos.sideToMove = BLACK;
+	}
+	else {
+		return false;
+	}
+
+	pos.castling = 0;
+	if (castling != "-") {
+		for (char ch : castling) {
+			switch (ch) {
+			case 'K': pos.castling |= CASTLE_WHITE_KING; break;
+			case 'Q': pos.castling |= CASTLE_WHITE_QUEEN; break;
+			case 'k': pos.castling |= CASTLE_BLACK_KING; break;
+			case 'q': pos.castling |= CASTLE_BLACK_QUEEN; break;
+			default: return false;
+			}
+		}
+	}
+	// Un derecho sin el rey o la torre en su casilla no se puede usar nunca: se descarta para
+	// que no cambie la clave de la posición
+	const int homeRows[2] = { 0, 7 };
+	for (int row : homeRows) {
+		PieceColor color = (row == 0) ? WHITE : BLACK;
+		const ChessPiece& king = pos.board[row][4];
+		for (int col = 0; col < 8; col += 7) {
+			const ChessPiece& rook = pos.board[row][col];
+			if (king.type != KING || king.color != color || rook.type != ROOK || rook.color != color) {
+				pos.castling &= (uint8_t)~CastlingRightsAt(row, col);
+			}
+		}
+	}
+
+	pos.enPassantCol = -1;
+	if (enPassant != "-") {
+		int passantRow = (pos.sideToMove == WHITE) ? 5 : 2;
+		if (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' || enPassant[1] != '1' + passantRow) {
+			return false;
+		}
+		// Solo vale si detrás de la casilla está el peón rival que acaba de avanzar dos
+		int col = enPassant[0] - 'a';
+		int pawnRow = (pos.sideToMove == WHITE) ? 4 : 3;
+		const ChessPiece& pawn = pos.board[pawnRow][col];
+		if (pos.board[passantRow][col].type == EMPTY && pawn.type == PAWN && pawn.color == Opponent(pos.sideToMove)) {
+			pos.enPassantCol = col;
+		}
+	}
+	return true;
+}
+
+// Escribe la posición en FEN. Los contadores de jugadas no se guardan en Position y quedan
+// en sus valores iniciales.
+inline std::string PositionToFEN(const Position& pos) {
+	std::string fen;
+	for (int row = 7; row >= 0; --row) {
+		int empty = 0;
+		for (int col = 0; col < 8; ++col) {
+			const ChessPiece& piece = pos.board[row][col];
+			if (piece.type == EMPTY) {
+				++empty;
+				continue;
+			}
+			if (empty > 0) {
+				fen += (char)('0' + empty);
+				empty = 0;
+			}
+			char letter = " prnbqk"[piece.type];
+			fen += (piece.color == WHITE) ? (char)(letter - 0x20) : letter; // Mayúscula para las blancas
+		}
+		if (empty > 0) {
+			fen += (char)('0' + empty);
+		}
+		if (row > 0) {
+			fen += '/';
+		}
+	}
+	fen += (pos.sideToMove == WHITE) ? " w " : " b ";
+	if (pos.castling == 0) {
+		fen += '-';
+	}
+	const char rights[] = "KQkq";
+	for (int i = 0; i < 4; ++i) {
+		if (pos.castling & (1 << i)) {
+			fen += rights[i];
+		}
+	}
+	if (pos.enPassantCol >= 0) {
+		fen += ' ';
+		fen += (char)('a' + pos.enPassantCol);
+		fen += (pos.sideToMove == WHITE) ? '6' : '3';
+	}
+	else {
+		fen += " -";
+	}
+	fen += " 0 1";
+	return fen;
+}
+
+// Claves Zobrist: un número aleatorio fijo por (color, tipo, casilla), otro para el turno,
+// uno por combinación de derechos de enroque (cero sin derechos) y uno por columna de captura al paso.
+// La clave de una posición es el XOR de los números de sus piezas, así que dos posiciones
+// iguales siempre tienen la misma clave aunque se lleguen por órdenes de jugadas distintos.
+struct ZobristKeys {
+	uint64_t pieces[3][7][64];
+	uint64_t blackToMove;
+	uint64_t castling[16];
+	uint64_t enPassant[8];
+
+	ZobristKeys() {
+		uint64_t seed = 0x9E3779B97F4A7C15ull;
+		for (int color = 0; color < 3; ++color) {
+			for (int type = 0; type < 7; ++type) {
+				for (int square = 0; square < 64; ++square) {
+					pieces[color][type][square] = next(seed);
+				}
+			}
+		}
+		blackToMove = next(seed);
+		castling[0] = 0;
+		for (int rights = 1; rights < 16; ++rights) {
+			castling[rights] = next(seed);
+		}
+		for (int col = 0; col < 8; ++col) {
+			enPassant[col] = next(seed);
+		}
+	}
+
+private:
+	// splitmix64: suficiente para claves de tablas y siempre da los mismos valores
+	static uint64_t next(uint64_t& state) {
+		uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+};
+
+inline const ZobristKeys& GetZobristKeys() {
+	static const ZobristKeys keys;
+	return keys;
+}
+
+inline uint64_t PositionKey(const Position& pos) {
+	const ZobristKeys& keys = GetZobristKeys();
+	uint64_t key = (pos.sideToMove == BLACK) ? keys.blackToMove : 0;
+	key ^= keys.castling[pos.castling];
+	if (pos.enPassantCol >= 0) {
+		key ^= keys.enPassant[pos.enPassantCol];
+	}
+	for (int r = 0; r < 8; ++r) {
+		for (int c = 0; c < 8; ++c) {
+			const ChessPiece& piece = pos.board[r][c];
+			if (piece.type != EMPTY) {
+				key ^= keys.pieces[piece.color][piece.type][r * 8 + c];
+			}
+		}
+	}
+	return key;
+}
+
+// Clave de la posición que resulta de aplicar move, calculada antes de hacer el movimiento
+// a partir de la clave actual (más barato que volver a recorrer las 64 casillas).
+inline uint64_t KeyAfterMove(uint64_t key, const Position& pos, const ChessMove& move) {
+	const ZobristKeys& keys = GetZobristKeys();
+	const ChessPiece& moved = pos.board[move.fromRow][move.fromCol];
+	const ChessPiece& captured = pos.board[move.toRow][move.toCol];
+	int from = move.fromRow * 8 + move.fromCol;
+	int to = move.toRow * 8 + move.toCol;
+	key ^= keys.pieces[moved.color][moved.type][from];
+	key ^= keys.pieces[moved.color][move.promotion != EMPTY ? move.promotion : moved.type][to];
+	if (captured.type != EMPTY) {
+		key ^= keys.pieces[captured.color][captured.type][to];
+	}
+	else if (IsEnPassantMove(pos, move)) {
+		key ^= keys.pieces[Opponent(moved.color)][PAWN][move.fromRow * 8 + move.toCol];
+	}
+	if (IsCastlingMove(pos, move)) {
+		int rookFrom = (move.toCol > move.fromCol) ? 7 : 0;
+		int rookTo = (move.toCol > move.fromCol) ? 5 : 3;
+		key ^= keys.pieces[moved.color][ROOK][move.fromRow * 8 + rookFrom];
+		key ^= keys.pieces[moved.color][ROOK][move.fromRow * 8 + rookTo];
+	}
+
+	uint8_t castling = pos.castling & (uint8_t)~(CastlingRightsAt(move.fromRow, move.fromCol) | CastlingRightsAt(move.toRow, move.toCol));
+	key ^= keys.castling[pos.castling] ^ keys.castling[castling];
+	if (pos.enPassantCol >= 0) {
+		key ^= keys.enPassant[pos.enPassantCol];
+	}
+	if (moved.type == PAWN && std::abs(move.toRow - move.fromRow) == 2) {
+		key ^= keys.enPassant[move.fromCol];
+	}
+	return key ^ keys.blackToMove;
+}
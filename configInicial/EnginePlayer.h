@@ -0,0 +1,217 @@
+#pragma once
+
+// Rival controlado por el motor para la ventana. La búsqueda corre en un hilo aparte para
+// que el render no se detenga; la ventana pregunta cada cuadro con PollMove si ya hay jugada.
+//
+// Mientras el jugador piensa, el motor "pondera": después de jugar, supone que el rival
+// responderá con la segunda jugada de su variante principal y se pone a buscar la posición
+// que resultaría. Si el jugador hace esa jugada, la búsqueda sigue sin reiniciarse y el
+// tiempo de reflexión cuenta desde que empezó a ponderar, así que muchas veces responde al
+// instante. Si hace otra jugada, la búsqueda se detiene y empieza una nueva. La tabla de
+// transposición se conserva entre jugadas, de modo que incluso en ese caso algo se reutiliza.
+//
+// El hilo de búsqueda es uno solo y dura lo que el objeto. Empezar o detener una búsqueda
+// solo deja el pedido y levanta la bandera de parada; la ventana nunca espera a que la
+// búsqueda anterior termine (el número de generación descarta lo que esa búsqueda entregue).
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+#include <chrono>
+#include <memory>
+#include <iostream>
+
+#include "ChessRules.h"
+#include "Search.h"
+
+class EnginePlayer
+{
+public:
+	// La tabla se reserva al empezar la primera búsqueda, no al crear el objeto
+	explicit EnginePlayer(size_t ttMegabytes = 64) : ttMegabytes(ttMegabytes) {}
+
+	~EnginePlayer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->quit = true;
+			this->stop = true;
+		}
+		this->wake.notify_one();
+		if (this->worker.joinable())
+		{
+			this->worker.join();
+		}
+	}
+
+	EnginePlayer(const EnginePlayer&) = delete;
+	EnginePlayer& operator=(const EnginePlayer&) = delete;
+
+	void SetThinkTime(double seconds)
+	{
+		this->thinkSeconds = seconds;
+	}
+
+	// Empieza a pensar la jugada del motor en pos (le toca mover al motor)
+	void StartThinking(const Position& pos)
+	{
+		this->stopSearch();
+		this->searchPosition = pos;
+		this->launch(THINKING);
+	}
+
+	// El rival jugó move y la posición quedó en pos
+	void OpponentMoved(const ChessMove& move, const Position& pos)
+	{
+		if (this->state == PONDERING && move == this->expectedReply)
+		{
+			// Acierto: la búsqueda en curso ya es la de esta posición
+			this->ponderHits++;
+			this->state = THINKING;
+			std::cout << "Motor: se esperaba " << MoveToString(move) << ", sigue la misma busqueda" << std::endl;
+			return;
+		}
+		if (this->state == PONDERING)
+		{
+			this->ponderMisses++;
+		}
+		this->StartThinking(pos);
+	}
+
+	// Se llama cada cuadro. Devuelve true (una sola vez) cuando el motor decidió su jugada.
+	bool PollMove(ChessMove& move)
+	{
+		if (this->state != THINKING)
+		{
+			return false;
+		}
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->started).count();
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			if (this->finishedGeneration != this->generation)
+			{
+				if (elapsed >= this->thinkSeconds)
+				{
+					this->stop = true; // Se acabó el tiempo: la jugada llega en un cuadro próximo
+				}
+				return false;
+			}
+			std::swap(this->result, this->finishedResult);
+		}
+		this->state = IDLE;
+		if (this->result.bestMove.fromRow < 0)
+		{
+			return false; // Sin movimientos
+		}
+		move = this->result.bestMove;
+		std::cout << "Motor: " << MoveToString(move) << "  puntos " << this->result.score << "  profundidad "
+			<< this->result.depth << "  nodos " << this->result.nodes << "  ponder +" << this->ponderHits
+			<< " -" << this->ponderMisses << std::endl;
+
+		// Ponderar sobre la respuesta esperada
+		if (this->result.pv.size() >= 2 && this->result.pv[0] == move)
+		{
+			MoveUndo undo;
+			Position next = this->searchPosition;
+			MakeMove(next, move, undo);
+			this->expectedReply = this->result.pv[1];
+			MakeMove(next, this->expectedReply, undo);
+			this->searchPosition = next;
+			this->launch(PONDERING);
+		}
+		return true;
+	}
+
+	bool IsPondering() const
+	{
+		return this->state == PONDERING;
+	}
+
+private:
+	enum State { IDLE, THINKING, PONDERING };
+
+	size_t ttMegabytes;
+	std::unique_ptr<Searcher> searcher;	// Solo la usa el hilo
+	std::thread worker;
+	std::atomic<bool> stop{ false };
+	SearchResult result;		// Resultado de la última búsqueda que recogió PollMove
+	Position searchPosition;	// Posición que se está buscando
+	ChessMove expectedReply;	// Jugada del rival sobre la que se pondera
+	State state = IDLE;
+	double thinkSeconds = 1.5;
+	std::chrono::steady_clock::time_point started;
+	int ponderHits = 0;
+	int ponderMisses = 0;
+
+	std::mutex mutex;		// Protege lo de abajo
+	std::condition_variable wake;
+	Position requested;		// Posición de la próxima búsqueda
+	bool pending = false;	// Hay una búsqueda pedida que el hilo todavía no empezó
+	bool quit = false;
+	uint64_t generation = 0;			// Cambia con cada búsqueda pedida o detenida
+	uint64_t finishedGeneration = 0;	// Generación de la búsqueda que dejó finishedResult
+	SearchResult finishedResult;
+
+	void launch(State newState)
+	{
+		this->state = newState;
+		this->started = std::chrono::steady_clock::now();
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->requested = this->searchPosition;
+			this->pending = true;
+			this->generation++;
+			this->stop = true; // Si sigue una búsqueda anterior, que termine cuanto antes
+		}
+		if (!this->worker.joinable())
+		{
+			this->worker = std::thread([this]() { this->run(); });
+		}
+		this->wake.notify_one();
+	}
+
+	// No espera: la búsqueda en curso recibe la orden de parar y su resultado se descarta
+	void stopSearch()
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->pending = false;
+		this->generation++;
+		this->stop = true;
+		this->state = IDLE;
+	}
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		while (true)
+		{
+			this->wake.wait(lock, [this]() { return this->pending || this->quit; });
+			if (this->quit)
+			{
+				return;
+			}
+			Position pos = this->requested;
+			uint64_t searchGeneration = this->generation;
+			this->pending = false;
+			this->stop = false;
+			lock.unlock();
+
+			if (!this->searcher)
+			{
+				this->searcher.reset(new Searcher(this->ttMegabytes));
+			}
+			SearchLimits limits;
+			limits.stop = &this->stop;
+			SearchResult searched = this->searcher->Search(pos, limits);
+
+			lock.lock();
+			if (this->generation == searchGeneration)
+			{
+				this->finishedResult = std::move(searched);
+				this->finishedGeneration = searchGeneration;
+			}
+		}
+	}
+};
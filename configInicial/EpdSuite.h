@@ -0,0 +1,286 @@
+#pragma once
+
+// Ejecuta suites de posiciones en formato EPD contra las reglas de ChessRules.h.
+// El archivo se lee por lotes: cada lote se reparte entre los hilos del ThreadPool y
+// los resultados se escriben en el mismo orden de entrada antes de leer el siguiente,
+// así que la memoria usada no depende del tamaño del archivo.
+//
+// Uso: configInicial.exe --epd suite.epd [hilos] [nodos]
+//
+// Por cada posición se imprime el número de movimientos legales (GenerateMoves ya descarta
+// los que dejan al rey en jaque). Si la línea trae la operación "D1 n" (como en las suites
+// de perft) se compara contra ese valor.
+//
+// Con nodos > 0 además se busca cada posición con ese límite (un Searcher por hilo, con la
+// tabla limpia antes de cada posición) y se imprime la mejor jugada y su puntuación. Si la
+// línea trae "bm" (en SAN o en coordenadas, una o varias jugadas) se dice si la jugada
+// encontrada es una de ellas.
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdlib>
+
+#include "ChessRules.h"
+#include "Search.h"
+#include "Pgn.h"
+#include "ThreadPool.h"
+
+const size_t EPD_SEARCH_MEGABYTES = 16;	// Tabla de cada Searcher en el modo con nodos
+
+// Resultado de analizar una línea del archivo EPD
+struct EpdResult
+{
+	bool parsed = false;
+	size_t moveCount = 0;
+	long long expectedD1 = -1;	// -1 si la línea no trae "D1"
+	std::string id;
+	double micros = 0.0;		// Tiempo que tomó analizar la posición
+
+	bool searched = false;		// Se buscó la mejor jugada (modo con nodos)
+	SearchResult search;
+	std::vector<ChessMove> bestMoves;	// Jugadas de "bm"
+	std::string bestMoveError;			// Jugada de "bm" que no se pudo leer, vacío si no hay
+	bool bestMoveFound = false;			// La jugada de la búsqueda está en bestMoves
+};
+
+// Histograma de latencias en potencias de dos de microsegundos: [0,1), [1,2), [2,4), ...
+class LatencyHistogram
+{
+public:
+	static const int BUCKETS = 24;
+
+	void Add(double micros)
+	{
+		int bucket = 0;
+		while (bucket < BUCKETS - 1 && micros >= (double)(1LL << bucket))
+		{
+			bucket++;
+		}
+		this->counts[bucket]++;
+		this->total++;
+	}
+
+	void Print(std::ostream& out) const
+	{
+		for (int i = 0; i < BUCKETS; i++)
+		{
+			if (this->counts[i] == 0)
+			{
+				continue;
+			}
+			long long low = (i == 0) ? 0 : (1LL << (i - 1));
+			double percent = 100.0 * this->counts[i] / this->total;
+			out << "  " << std::setw(9) << low << " - " << std::setw(9) << (1LL << i) << " us: "
+				<< std::setw(9) << this->counts[i] << " (" << std::fixed << std::setprecision(1) << percent << "%)" << std::endl;
+		}
+	}
+
+private:
+	long long counts[BUCKETS] = {};
+	long long total = 0;
+};
+
+// Lee una jugada de "bm": primero en coordenadas (e2e4, e7e8q) y si no en SAN
+inline bool ParseEpdMove(const Position& pos, const std::vector<ChessMove>& moves, const std::string& text, ChessMove& move)
+{
+	for (const ChessMove& candidate : moves)
+	{
+		if (MoveToString(candidate) == text)
+		{
+			move = candidate;
+			return true;
+		}
+	}
+	std::string error;
+	return ResolveSan(pos, moves, text, move, error);
+}
+
+// Separa una línea EPD en FEN (tablero, turno, enroque, al paso) y sus operaciones. Con
+// searcher busca además la mejor jugada con nodeLimit nodos.
+inline EpdResult AnalyzeEpdLine(const std::string& line, Searcher* searcher = nullptr, uint64_t nodeLimit = 0)
+{
+	EpdResult result;
+	auto start = std::chrono::steady_clock::now();
+
+	std::istringstream stream(line);
+	std::string fields[4];
+	for (std::string& field : fields)
+	{
+		stream >> field;
+	}
+	std::string operations;
+	std::getline(stream, operations);
+
+	Position pos;
+	std::vector<ChessMove> moves;
+	result.parsed = LoadFEN(pos, fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3]);
+	if (result.parsed)
+	{
+		GenerateMoves(pos, moves);
+		result.moveCount = moves.size();
+	}
+
+	// Operaciones separadas por ';', por ejemplo: id "pos 1"; D1 20; D2 400;
+	std::istringstream opStream(operations);
+	std::string op;
+	while (std::getline(opStream, op, ';'))
+	{
+		std::istringstream opFields(op);
+		std::string opcode;
+		opFields >> opcode;
+		if (opcode == "D1")
+		{
+			opFields >> result.expectedD1;
+		}
+		else if (opcode == "id")
+		{
+			std::getline(opFields >> std::ws, result.id);
+		}
+		else if (opcode == "bm" && result.parsed)
+		{
+			std::string text;
+			while (opFields >> text)
+			{
+				ChessMove move;
+				if (!ParseEpdMove(pos, moves, text, move))
+				{
+					result.bestMoveError = text;
+					break;
+				}
+				result.bestMoves.push_back(move);
+			}
+		}
+	}
+
+	if (searcher != nullptr && result.parsed && !moves.empty())
+	{
+		searcher->Hash().Clear();
+		SearchLimits limits;
+		limits.nodes = nodeLimit;
+		result.search = searcher->Search(pos, limits);
+		result.searched = true;
+		for (const ChessMove& move : result.bestMoves)
+		{
+			result.bestMoveFound |= (move == result.search.bestMove);
+		}
+	}
+
+	result.micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+// Escribe el resultado de una posición en una línea (sin el número de posición)
+inline void WriteEpdResult(std::ostream& out, const EpdResult& result)
+{
+	if (!result.parsed)
+	{
+		out << "FEN invalido" << std::endl;
+		return;
+	}
+	out << "movimientos=" << result.moveCount;
+	if (result.expectedD1 >= 0)
+	{
+		out << "\tD1=" << result.expectedD1 << ((long long)result.moveCount == result.expectedD1 ? "\tOK" : "\tDIFERENTE");
+	}
+	if (result.searched)
+	{
+		out << "\tmejor=" << MoveToString(result.search.bestMove) << "\tpuntos=" << result.search.score
+			<< "\tprofundidad=" << result.search.depth;
+	}
+	if (!result.bestMoveError.empty())
+	{
+		out << "\tbm invalida: " << result.bestMoveError;
+	}
+	else if (result.searched && !result.bestMoves.empty())
+	{
+		out << "\tbm=";
+		for (size_t i = 0; i < result.bestMoves.size(); i++)
+		{
+			out << (i > 0 ? "," : "") << MoveToString(result.bestMoves[i]);
+		}
+		out << (result.bestMoveFound ? "\tOK" : "\tDIFERENTE");
+	}
+	if (!result.id.empty())
+	{
+		out << "\t" << result.id;
+	}
+	out << std::endl;
+}
+
+// nodeLimit = 0 solo cuenta movimientos; si no, busca cada posición con ese límite
+inline int RunEpdSuite(const std::string& path, int numThreads, uint64_t nodeLimit, std::ostream& out)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cerr << "ERROR::EPD::NO_SE_PUDO_ABRIR " << path << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const size_t BATCH_SIZE = 4096;
+	ThreadPool pool(numThreads);
+	std::vector<std::unique_ptr<Searcher>> searchers(pool.Size());
+	std::vector<std::string> lines;
+	std::vector<EpdResult> results(BATCH_SIZE);
+	lines.reserve(BATCH_SIZE);
+
+	LatencyHistogram histogram;
+	long long positions = 0, invalid = 0, mismatches = 0, bestMoveTests = 0, bestMoveHits = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	std::string line;
+	bool moreLines = true;
+	while (moreLines)
+	{
+		lines.clear();
+		while (lines.size() < BATCH_SIZE && (moreLines = (bool)std::getline(file, line)))
+		{
+			if (line.find_first_not_of(" \t\r") != std::string::npos)
+			{
+				lines.push_back(line);
+			}
+		}
+
+		pool.ParallelFor(lines.size(), [&](size_t i, int threadId) {
+			if (nodeLimit > 0 && !searchers[threadId])
+			{
+				searchers[threadId].reset(new Searcher(EPD_SEARCH_MEGABYTES));
+			}
+			results[i] = AnalyzeEpdLine(lines[i], searchers[threadId].get(), nodeLimit);
+		});
+
+		// Escritura en el orden del archivo
+		for (size_t i = 0; i < lines.size(); i++)
+		{
+			const EpdResult& result = results[i];
+			positions++;
+			histogram.Add(result.micros);
+			invalid += (result.parsed && result.bestMoveError.empty()) ? 0 : 1;
+			bestMoveTests += (result.searched && !result.bestMoves.empty() && result.bestMoveError.empty()) ? 1 : 0;
+			bestMoveHits += (result.searched && result.bestMoveFound) ? 1 : 0;
+			mismatches += (result.parsed && result.expectedD1 >= 0 && (long long)result.moveCount != result.expectedD1) ? 1 : 0;
+			out << positions << "\t";
+			WriteEpdResult(out, result);
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cerr << "Posiciones: " << positions << "  invalidas: " << invalid << "  D1 diferentes: " << mismatches
+		<< "  hilos: " << pool.Size() << std::endl;
+	if (nodeLimit > 0)
+	{
+		std::cerr << "Mejor jugada: " << bestMoveHits << " de " << bestMoveTests << " iguales a bm (" << nodeLimit
+			<< " nodos por posicion)" << std::endl;
+	}
+	std::cerr << "Tiempo: " << std::fixed << std::setprecision(3) << seconds << " s  ("
+		<< std::setprecision(0) << (seconds > 0.0 ? positions / seconds : 0.0) << " posiciones/s)" << std::endl;
+	std::cerr << "Latencia por posicion:" << std::endl;
+	histogram.Print(std::cerr);
+	return (invalid == 0 && mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+// Datos de cámara y luz de cada cuadro en un solo uniform buffer (std140) compartido por
+// todos los shaders. Se sube una vez por cuadro y queda enlazado al punto
+// FRAME_UNIFORM_BINDING; cada programa conecta ahí su bloque FrameData al enlazarse (Shader.h),
+// así que agregar programas no agrega subidas de view y projection.
+//
+// Bloque que declaran los shaders de Shader/ (debe coincidir con FrameUniformData):
+//
+//   layout (std140) uniform FrameData
+//   {
+//       mat4 view;
+//       mat4 projection;
+//       mat4 viewProjection;
+//       vec4 cameraPosition;    // xyz
+//       vec4 lightPosition;     // xyz
+//       vec4 lightColor;        // rgb
+//   };
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "GLStateCache.h"
+
+const GLuint FRAME_UNIFORM_BINDING = 0;
+const GLchar* const FRAME_UNIFORM_BLOCK = "FrameData";
+
+// En std140 una mat4 son cuatro vec4 seguidos y cada vec4 se alinea a 16 bytes: con solo
+// mat4 y vec4 la estructura de C++ tiene la misma disposición que el bloque
+struct FrameUniformData
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::vec4 cameraPosition;
+	glm::vec4 lightPosition;
+	glm::vec4 lightColor;
+};
+
+static_assert(sizeof(FrameUniformData) == 3 * 64 + 3 * 16, "FrameUniformData debe seguir la disposicion std140 de FrameData");
+
+class FrameUniforms
+{
+public:
+	// Requiere el contexto de OpenGL
+	void Init()
+	{
+		glGenBuffers(1, &this->buffer);
+		GLState().BindBuffer(GL_UNIFORM_BUFFER, this->buffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformData), nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, this->buffer);
+	}
+
+	// Sube los datos del cuadro: una sola escritura para todos los programas
+	void Update(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPosition,
+		const glm::vec3& lightPosition, const glm::vec3& lightColor)
+	{
+		this->data.view = view;
+		this->data.projection = projection;
+		this->data.viewProjection = projection * view;
+		this->data.cameraPosition = glm::vec4(cameraPosition, 1.0f);
+		this->data.lightPosition = glm::vec4(lightPosition, 1.0f);
+		this->data.lightColor = glm::vec4(lightColor, 1.0f);
+		GLState().BindBuffer(GL_UNIFORM_BUFFER, this->buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniformData), &this->data);
+	}
+
+	const FrameUniformData& Data() const
+	{
+		return this->data;
+	}
+
+private:
+	GLuint buffer = 0;
+	FrameUniformData data;
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+// Capa delgada sobre los enlaces de estado de OpenGL (programa, VAO, búferes, texturas por
+// unidad y capacidades glEnable/glDisable). Recuerda lo último que se enlazó y no vuelve a
+// llamar al driver si se pide lo mismo: el tablero, las piezas y los overlays enlazan cada
+// cuadro casi lo mismo que el cuadro anterior.
+//
+// Todo el código del programa debe enlazar a través de GLState(); un glBind* directo dejaría
+// la caché desfasada (si no se puede evitar, llamar Invalidate() después).
+//
+// GL_STATE_CACHE = 0 (por ejemplo en las definiciones del preprocesador del proyecto) deja
+// solo el conteo: cada llamada llega al driver, como sin la capa.
+
+#include <GL/glew.h>
+#include <cstdint>
+
+#ifndef GL_STATE_CACHE
+#define GL_STATE_CACHE 1
+#endif
+
+class GLStateCache
+{
+public:
+	GLStateCache()
+	{
+		this->Invalidate();
+	}
+
+	void UseProgram(GLuint program)
+	{
+		if (this->redundant(this->program, program))
+		{
+			return;
+		}
+		glUseProgram(program);
+	}
+
+	void BindVertexArray(GLuint vertexArray)
+	{
+		if (this->redundant(this->vertexArray, vertexArray))
+		{
+			return;
+		}
+		glBindVertexArray(vertexArray);
+		// El búfer de índices es parte del VAO: con otro VAO enlazado ya no se sabe cuál es
+		this->buffers[ELEMENT_BUFFER] = UNKNOWN;
+	}
+
+	void BindBuffer(GLenum target, GLuint buffer)
+	{
+		int slot = bufferSlot(target);
+		if (slot >= 0 && this->redundant(this->buffers[slot], buffer))
+		{
+			return;
+		}
+		if (slot < 0)
+		{
+			this->frameIssued++;
+		}
+		glBindBuffer(target, buffer);
+	}
+
+	// Enlaza texture a target en la unidad unit (cambia la unidad activa solo si hace falta)
+	void BindTexture(GLuint unit, GLenum target, GLuint texture)
+	{
+		int slot = textureSlot(target);
+		if (unit < MAX_UNITS && slot >= 0 && this->redundant(this->textures[unit][slot], texture))
+		{
+			return;
+		}
+		if (unit >= MAX_UNITS || slot < 0)
+		{
+			this->frameIssued++;
+		}
+		this->activateUnit(unit);
+		glBindTexture(target, texture);
+	}
+
+	void Enable(GLenum capability)
+	{
+		this->setCapability(capability, true);
+	}
+
+	void Disable(GLenum capability)
+	{
+		this->setCapability(capability, false);
+	}
+
+	// Olvida todo lo recordado (después de código que enlaza por su cuenta)
+	void Invalidate()
+	{
+		this->program = UNKNOWN;
+		this->vertexArray = UNKNOWN;
+		this->activeUnit = UNKNOWN;
+		for (GLuint& buffer : this->buffers)
+		{
+			buffer = UNKNOWN;
+		}
+		for (GLuint (&unit)[TEXTURE_TARGETS] : this->textures)
+		{
+			for (GLuint& texture : unit)
+			{
+				texture = UNKNOWN;
+			}
+		}
+		for (GLuint& capability : this->capabilities)
+		{
+			capability = UNKNOWN;
+		}
+	}
+
+	// Empieza a contar un cuadro nuevo y acumula el anterior en los totales (lo anterior al
+	// primer cuadro es la carga y no se acumula)
+	void BeginFrame()
+	{
+		if (this->frames > 0)
+		{
+			this->totalIssued += this->frameIssued;
+			this->totalSkipped += this->frameSkipped;
+		}
+		this->frames++;
+		this->frameIssued = 0;
+		this->frameSkipped = 0;
+	}
+
+	// Llamadas que llegaron al driver y que se omitieron por redundantes en el cuadro actual
+	uint64_t FrameIssued() const
+	{
+		return this->frameIssued;
+	}
+
+	uint64_t FrameSkipped() const
+	{
+		return this->frameSkipped;
+	}
+
+	// Promedios por cuadro de los cuadros ya terminados
+	double AverageIssued() const
+	{
+		return this->frames > 1 ? (double)this->totalIssued / (this->frames - 1) : 0.0;
+	}
+
+	double AverageSkipped() const
+	{
+		return this->frames > 1 ? (double)this->totalSkipped / (this->frames - 1) : 0.0;
+	}
+
+private:
+	static const GLuint UNKNOWN = 0xFFFFFFFFu;	// Ningún nombre de GL vale esto
+	static const GLuint MAX_UNITS = 16;
+	static const int ELEMENT_BUFFER = 1;
+	static const int TEXTURE_TARGETS = 2;
+	static const int CAPABILITIES = 4;
+
+	GLuint program = UNKNOWN;
+	GLuint vertexArray = UNKNOWN;
+	GLuint activeUnit = UNKNOWN;
+	GLuint buffers[4] = { UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };	// GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_UNIFORM_BUFFER
+	GLuint textures[MAX_UNITS][TEXTURE_TARGETS];			// GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY
+	GLuint capabilities[CAPABILITIES] = { UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+	uint64_t frameIssued = 0;
+	uint64_t frameSkipped = 0;
+	uint64_t totalIssued = 0;
+	uint64_t totalSkipped = 0;
+	uint64_t frames = 0;
+
+	// Cuenta la llamada y dice si se puede omitir; si no, recuerda el valor nuevo
+	bool redundant(GLuint& cached, GLuint value)
+	{
+#if GL_STATE_CACHE
+		if (cached == value)
+		{
+			this->frameSkipped++;
+			return true;
+		}
+#endif
+		cached = value;
+		this->frameIssued++;
+		return false;
+	}
+
+	void activateUnit(GLuint unit)
+	{
+		if (this->redundant(this->activeUnit, unit))
+		{
+			return;
+		}
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+
+	void setCapability(GLenum capability, bool enabled)
+	{
+		int slot = capabilitySlot(capability);
+		if (slot >= 0 && this->redundant(this->capabilities[slot], enabled ? 1 : 0))
+		{
+			return;
+		}
+		if (slot < 0)
+		{
+			this->frameIssued++;
+		}
+		if (enabled)
+		{
+			glEnable(capability);
+		}
+		else
+		{
+			glDisable(capability);
+		}
+	}
+
+	// Los destinos que no se recuerdan (-1) siempre llegan al driver
+	static int bufferSlot(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_ARRAY_BUFFER: return 0;
+		case GL_ELEMENT_ARRAY_BUFFER: return ELEMENT_BUFFER;
+		case GL_DRAW_INDIRECT_BUFFER: return 2;
+		case GL_UNIFORM_BUFFER: return 3;
+		default: return -1;
+		}
+	}
+
+	static int textureSlot(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_TEXTURE_2D: return 0;
+		case GL_TEXTURE_2D_ARRAY: return 1;
+		default: return -1;
+		}
+	}
+
+	static int capabilitySlot(GLenum capability)
+	{
+		switch (capability)
+		{
+		case GL_DEPTH_TEST: return 0;
+		case GL_BLEND: return 1;
+		case GL_CULL_FACE: return 2;
+		case GL_SCISSOR_TEST: return 3;
+		default: return -1;
+		}
+	}
+};
+
+// El estado de GL del único contexto del programa
+inline GLStateCache& GLState()
+{
+	static GLStateCache state;
+	return state;
+}
@@ -0,0 +1,369 @@
+#pragma once
+
+// Archivo binario compacto de partidas.
+// Cada jugada se guarda en un byte: su índice dentro de la lista de GenerateMoves de la
+// posición en la que se jugó. Las etiquetas se guardan una sola vez en una tabla de
+// textos y un índice de desplazamientos permite ir directo a la partida N sin leer las
+// anteriores. Todo es de ancho fijo y little-endian, así que se lee proyectando el
+// archivo en memoria (MappedFile) sin ningún paso de carga.
+//
+// Estructura:
+//   ArchiveHeader
+//   Registros de partida: ArchiveGameRecord, etiquetas (pares de uint32), jugadas (uint8)
+//   Índice de partidas: gameCount x uint64 (desplazamiento de cada registro)
+//   Tabla de textos: stringCount x uint32 (desplazamiento dentro del bloque) + bloque de textos terminados en '\0'
+//
+// Uso: configInicial.exe --pgn2bin partidas.pgn partidas.bin [hilos]
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+#include "ChessRules.h"
+#include "Pgn.h"
+#include "ThreadPool.h"
+#include "MappedFile.h"
+
+const char ARCHIVE_MAGIC[4] = { 'A', 'J', 'D', 'Z' };
+const uint32_t ARCHIVE_VERSION = 2;				// 2: índices en la lista de jugadas legales (con enroque y al paso)
+const uint32_t ARCHIVE_NO_STRING = 0xFFFFFFFFu;
+
+struct ArchiveHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t gameCount;
+	uint32_t stringCount;
+	uint64_t indexOffset;
+	uint64_t stringsOffset;
+};
+
+struct ArchiveGameRecord
+{
+	uint32_t fenString;		// ARCHIVE_NO_STRING si parte de la posición inicial normal
+	uint32_t tagCount;
+	uint32_t plyCount;
+};
+
+// Partida leída del archivo, con las jugadas ya decodificadas
+struct ArchivedGame
+{
+	std::vector<std::pair<std::string, std::string>> tags;
+	Position start;
+	std::vector<ChessMove> moves;
+};
+
+// Convierte las jugadas de una partida en índices de un byte. Devuelve false si alguna
+// posición tiene más de 256 movimientos válidos y el índice no cabe.
+inline bool EncodeArchiveMoves(const PgnReplay& replay, std::vector<uint8_t>& encoded)
+{
+	encoded.clear();
+	Position pos = replay.start;
+	std::vector<ChessMove> moves;
+	MoveUndo undo;
+	for (const ChessMove& played : replay.moves)
+	{
+		GenerateMoves(pos, moves);
+		size_t index = 0;
+		while (index < moves.size() && !(moves[index] == played))
+		{
+			index++;
+		}
+		if (index >= moves.size() || index > 0xFF)
+		{
+			return false;
+		}
+		encoded.push_back((uint8_t)index);
+		MakeMove(pos, played, undo);
+	}
+	return true;
+}
+
+class GameArchiveWriter
+{
+public:
+	bool Open(const std::string& path)
+	{
+		this->out.open(path, std::ios::binary | std::ios::trunc);
+		if (!this->out)
+		{
+			return false;
+		}
+		ArchiveHeader header = {};
+		this->out.write((const char*)&header, sizeof(header)); // Se reescribe en Close()
+		this->offsets.clear();
+		this->strings.clear();
+		this->stringIds.clear();
+		return true;
+	}
+
+	void AddGame(const std::vector<std::pair<std::string, std::string>>& tags, const std::string& fen, const std::vector<uint8_t>& moves)
+	{
+		this->offsets.push_back((uint64_t)this->out.tellp());
+
+		ArchiveGameRecord record;
+		record.fenString = fen.empty() ? ARCHIVE_NO_STRING : this->internString(fen);
+		record.tagCount = (uint32_t)tags.size();
+		record.plyCount = (uint32_t)moves.size();
+		this->out.write((const char*)&record, sizeof(record));
+
+		for (const auto& tag : tags)
+		{
+			uint32_t pair[2] = { this->internString(tag.first), this->internString(tag.second) };
+			this->out.write((const char*)pair, sizeof(pair));
+		}
+		if (!moves.empty())
+		{
+			this->out.write((const char*)moves.data(), moves.size());
+		}
+		// Relleno para que el siguiente registro quede alineado a 4 bytes
+		static const char padding[4] = {};
+		this->out.write(padding, (4 - moves.size() % 4) % 4);
+	}
+
+	bool Close()
+	{
+		ArchiveHeader header;
+		std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+		header.version = ARCHIVE_VERSION;
+		header.gameCount = (uint32_t)this->offsets.size();
+		header.stringCount = (uint32_t)this->strings.size();
+
+		header.indexOffset = (uint64_t)this->out.tellp();
+		if (!this->offsets.empty())
+		{
+			this->out.write((const char*)this->offsets.data(), this->offsets.size() * sizeof(uint64_t));
+		}
+
+		header.stringsOffset = (uint64_t)this->out.tellp();
+		uint32_t blobOffset = 0;
+		for (const std::string& text : this->strings)
+		{
+			this->out.write((const char*)&blobOffset, sizeof(blobOffset));
+			blobOffset += (uint32_t)text.size() + 1;
+		}
+		for (const std::string& text : this->strings)
+		{
+			this->out.write(text.c_str(), text.size() + 1);
+		}
+
+		this->out.seekp(0);
+		this->out.write((const char*)&header, sizeof(header));
+		this->out.close();
+		return !this->out.fail();
+	}
+
+private:
+	std::ofstream out;
+	std::vector<uint64_t> offsets;
+	std::vector<std::string> strings;
+	std::unordered_map<std::string, uint32_t> stringIds;
+
+	uint32_t internString(const std::string& text)
+	{
+		auto found = this->stringIds.find(text);
+		if (found != this->stringIds.end())
+		{
+			return found->second;
+		}
+		uint32_t id = (uint32_t)this->strings.size();
+		this->strings.push_back(text);
+		this->stringIds.emplace(text, id);
+		return id;
+	}
+};
+
+class GameArchive
+{
+public:
+	bool Open(const std::string& path)
+	{
+		if (!this->file.Open(path) || this->file.Size() < sizeof(ArchiveHeader))
+		{
+			return false;
+		}
+		std::memcpy(&this->header, this->file.Data(), sizeof(this->header));
+		if (std::memcmp(this->header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || this->header.version != ARCHIVE_VERSION ||
+			this->header.indexOffset + (uint64_t)this->header.gameCount * sizeof(uint64_t) > this->file.Size() ||
+			this->header.stringsOffset + (uint64_t)this->header.stringCount * sizeof(uint32_t) > this->file.Size())
+		{
+			this->file.Close();
+			return false;
+		}
+		// Los textos van al final del archivo, después de sus desplazamientos
+		uint64_t blobStart = this->header.stringsOffset + (uint64_t)this->header.stringCount * sizeof(uint32_t);
+		this->stringBlob = (const char*)this->file.Data() + blobStart;
+		this->stringBlobSize = this->file.Size() - blobStart;
+		return true;
+	}
+
+	uint32_t GameCount() const
+	{
+		return this->header.gameCount;
+	}
+
+	// Texto número id de la tabla de textos ("" si el id o su desplazamiento no son válidos,
+	// o si el texto no termina antes del final del archivo)
+	const char* String(uint32_t id) const
+	{
+		if (id >= this->header.stringCount)
+		{
+			return "";
+		}
+		uint32_t offset;
+		std::memcpy(&offset, this->file.Data() + this->header.stringsOffset + (uint64_t)id * sizeof(uint32_t), sizeof(offset));
+		if (offset >= this->stringBlobSize ||
+			std::memchr(this->stringBlob + offset, '\0', (size_t)(this->stringBlobSize - offset)) == nullptr)
+		{
+			return "";
+		}
+		return this->stringBlob + offset;
+	}
+
+	// Lee la partida número index (desde 0) con todas sus jugadas
+	bool ReadGame(uint32_t index, ArchivedGame& game) const
+	{
+		return this->decode(index, 0xFFFFFFFFu, game, nullptr);
+	}
+
+	// Posición de la partida index después de ply jugadas (0 = posición inicial)
+	bool PositionAt(uint32_t index, uint32_t ply, Position& pos) const
+	{
+		ArchivedGame game;
+		return this->decode(index, ply, game, &pos);
+	}
+
+private:
+	MappedFile file;
+	const char* stringBlob = nullptr;	// Textos terminados en cero, uno tras otro
+	uint64_t stringBlobSize = 0;
+	ArchiveHeader header = {};
+
+	bool decode(uint32_t index, uint32_t maxPly, ArchivedGame& game, Position* finalPos) const
+	{
+		if (index >= this->header.gameCount)
+		{
+			return false;
+		}
+		uint64_t offset;
+		std::memcpy(&offset, this->file.Data() + this->header.indexOffset + index * sizeof(uint64_t), sizeof(offset));
+		ArchiveGameRecord record;
+		if (offset + sizeof(record) > this->file.Size())
+		{
+			return false;
+		}
+		std::memcpy(&record, this->file.Data() + offset, sizeof(record));
+		const unsigned char* tagData = this->file.Data() + offset + sizeof(record);
+		const unsigned char* moveData = tagData + (size_t)record.tagCount * 2 * sizeof(uint32_t);
+		if (moveData + record.plyCount > this->file.Data() + this->file.Size() || (maxPly != 0xFFFFFFFFu && maxPly > record.plyCount))
+		{
+			return false;
+		}
+
+		game.tags.clear();
+		for (uint32_t i = 0; i < record.tagCount; i++)
+		{
+			uint32_t pair[2];
+			std::memcpy(pair, tagData + i * sizeof(pair), sizeof(pair));
+			game.tags.emplace_back(this->String(pair[0]), this->String(pair[1]));
+		}
+
+		const char* fen = (record.fenString == ARCHIVE_NO_STRING) ? START_FEN : this->String(record.fenString);
+		if (!LoadFEN(game.start, fen))
+		{
+			return false;
+		}
+
+		uint32_t plies = (maxPly < record.plyCount) ? maxPly : record.plyCount;
+		Position pos = game.start;
+		std::vector<ChessMove> moves;
+		MoveUndo undo;
+		game.moves.clear();
+		game.moves.reserve(plies);
+		for (uint32_t ply = 0; ply < plies; ply++)
+		{
+			GenerateMoves(pos, moves);
+			if (moveData[ply] >= moves.size())
+			{
+				return false;
+			}
+			const ChessMove& move = moves[moveData[ply]];
+			game.moves.push_back(move);
+			MakeMove(pos, move, undo);
+		}
+		if (finalPos != nullptr)
+		{
+			*finalPos = pos;
+		}
+		return true;
+	}
+};
+
+// Convierte un archivo PGN a formato binario. Las partidas ilegales se omiten.
+inline int ConvertPgnToArchive(const std::string& pgnPath, const std::string& archivePath, int numThreads)
+{
+	PgnReader reader;
+	if (!reader.Open(pgnPath))
+	{
+		std::cerr << "ERROR::PGN::NO_SE_PUDO_ABRIR " << pgnPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	GameArchiveWriter writer;
+	if (!writer.Open(archivePath))
+	{
+		std::cerr << "ERROR::ARCHIVO::NO_SE_PUDO_CREAR " << archivePath << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const size_t BATCH_SIZE = 1024;
+	ThreadPool pool(numThreads);
+	std::vector<PgnGame> games(BATCH_SIZE);
+	std::vector<std::vector<uint8_t>> encoded(BATCH_SIZE);
+	std::vector<char> accepted(BATCH_SIZE);
+
+	long long total = 0, written = 0;
+	auto start = std::chrono::steady_clock::now();
+	bool moreGames = true;
+	while (moreGames)
+	{
+		size_t count = 0;
+		while (count < BATCH_SIZE && (moreGames = reader.Next(games[count])))
+		{
+			count++;
+		}
+
+		pool.ParallelFor(count, [&](size_t i, int) {
+			PgnReplay replay = ReplayPgnGame(games[i]);
+			accepted[i] = replay.legal && EncodeArchiveMoves(replay, encoded[i]);
+		});
+
+		for (size_t i = 0; i < count; i++)
+		{
+			total++;
+			if (accepted[i])
+			{
+				writer.AddGame(games[i].tags, games[i].GetTag("FEN"), encoded[i]);
+				written++;
+			}
+		}
+	}
+
+	if (!writer.Close())
+	{
+		std::cerr << "ERROR::ARCHIVO::NO_SE_PUDO_ESCRIBIR " << archivePath << std::endl;
+		return EXIT_FAILURE;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cerr << "Partidas: " << total << "  escritas: " << written << "  omitidas: " << (total - written) << std::endl;
+	std::cerr << "Tiempo: " << std::fixed << std::setprecision(3) << seconds << " s  ("
+		<< std::setprecision(0) << (seconds > 0.0 ? total / seconds : 0.0) << " partidas/s)" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+// Búfer de geometría compartido por todas las mallas.
+// Cada Mesh agrega sus vértices e índices al final de un solo VBO/EBO y recibe su rango
+// (primer índice, número de índices, vértice base). Todas las mallas se dibujan con el
+// mismo VAO, así que cambiar de malla ya no cambia de VAO, y muchas mallas se pueden
+// dibujar con una sola llamada glMultiDrawElementsIndirect a partir de una tabla de
+// comandos (GL 4.3 o ARB_multi_draw_indirect). Sin esa extensión se dibuja cada comando
+// con glDrawElementsInstancedBaseVertex.
+//
+// Los datos se juntan en CPU mientras se cargan los modelos y se suben a la GPU la primera
+// vez que se enlaza el VAO (o de nuevo si después se agregan mallas).
+
+#include <vector>
+#include <cstddef>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "GLStateCache.h"
+
+struct Vertex
+{
+	// Position
+	glm::vec3 Position;
+	// Normal
+	glm::vec3 Normal;
+	// TexCoords
+	glm::vec2 TexCoords;
+};
+
+// Datos de cada copia en el dibujo instanciado: transformación del modelo, color de
+// resaltado (negro = sin resaltar), capa de su piel en PieceSkinArray y matriz de normales
+// calculada en CPU. Los atributos 3-6 son las columnas de la matriz, el 7 el color, el 8 la
+// capa y 9-11 las columnas de la matriz de normales.
+struct MeshInstance
+{
+	glm::mat4 model;
+	glm::vec3 highlight;
+	GLfloat skinLayer;
+	glm::mat3 normal;
+};
+
+// Parte del búfer compartido que ocupa una malla
+struct MeshRange
+{
+	GLuint firstIndex = 0;
+	GLuint indexCount = 0;
+	GLint baseVertex = 0;
+};
+
+// Formato fijo de GL para cada comando de glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+class GeometryPool
+{
+public:
+	MeshRange AddMesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+	{
+		MeshRange range;
+		range.firstIndex = (GLuint)this->indices.size();
+		range.indexCount = (GLuint)indices.size();
+		range.baseVertex = (GLint)this->vertices.size();
+		this->vertices.insert(this->vertices.end(), vertices.begin(), vertices.end());
+		this->indices.insert(this->indices.end(), indices.begin(), indices.end());
+		this->dirty = true;
+		return range;
+	}
+
+	// Enlaza el VAO compartido, subiendo antes la geometría si cambió
+	void Bind()
+	{
+		if (this->dirty)
+		{
+			this->upload();
+		}
+		GLState().BindVertexArray(this->VAO);
+	}
+
+	// Conecta los atributos por copia (3-11) a instanceBuffer desde el byte offset. Con
+	// baseInstance disponible basta hacerlo una vez con offset 0.
+	void PointInstances(GLuint instanceBuffer, GLintptr offset)
+	{
+		this->Bind();
+		GLState().BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		for (GLuint column = 0; column < 4; column++)
+		{
+			glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+				(GLvoid *)(offset + offsetof(MeshInstance, model) + column * sizeof(glm::vec4)));
+		}
+		glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, sizeof(MeshInstance), (GLvoid *)(offset + offsetof(MeshInstance, highlight)));
+		glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, sizeof(MeshInstance), (GLvoid *)(offset + offsetof(MeshInstance, skinLayer)));
+		for (GLuint column = 0; column < 3; column++)
+		{
+			glVertexAttribPointer(9 + column, 3, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+				(GLvoid *)(offset + offsetof(MeshInstance, normal) + column * sizeof(glm::vec3)));
+		}
+		if (!this->instancingEnabled)
+		{
+			for (GLuint attribute = 3; attribute <= 11; attribute++)
+			{
+				glEnableVertexAttribArray(attribute);
+				glVertexAttribDivisor(attribute, 1); // Un valor por copia, no por vértice
+			}
+			this->instancingEnabled = true;
+		}
+	}
+
+	// glMultiDrawElementsIndirect con baseInstance (requiere un contexto creado)
+	bool SupportsMultiDrawIndirect() const
+	{
+		return GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+	}
+
+	size_t VertexCount() const
+	{
+		return this->vertices.size();
+	}
+
+	size_t IndexCount() const
+	{
+		return this->indices.size();
+	}
+
+private:
+	std::vector<Vertex> vertices;
+	std::vector<GLuint> indices;
+	GLuint VAO = 0, VBO = 0, EBO = 0;
+	bool dirty = false;
+	bool instancingEnabled = false;
+
+	void upload()
+	{
+		if (this->VAO == 0)
+		{
+			glGenVertexArrays(1, &this->VAO);
+			glGenBuffers(1, &this->VBO);
+			glGenBuffers(1, &this->EBO);
+		}
+		GLState().BindVertexArray(this->VAO);
+		GLState().BindBuffer(GL_ARRAY_BUFFER, this->VBO);
+		glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(Vertex), this->vertices.data(), GL_STATIC_DRAW);
+		GLState().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(GLuint), this->indices.data(), GL_STATIC_DRAW);
+
+		// Vertex Positions
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)0);
+		// Vertex Normals
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, Normal));
+		// Vertex Texture Coords
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, TexCoords));
+		this->dirty = false;
+	}
+};
+
+// El búfer de geometría de toda la aplicación
+inline GeometryPool& SharedGeometry()
+{
+	static GeometryPool pool;
+	return pool;
+}
@@ -0,0 +1,292 @@
+#pragma once
+
+// Memoria para tablas grandes (transposición, perft) con páginas de 2 MB cuando se puede.
+// Con páginas normales de 4 KB una tabla de varios GB necesita cientos de miles de entradas
+// en la TLB y casi cada acceso aleatorio falla en ella; con páginas grandes son 512 veces menos.
+//
+// Se intenta, en orden:
+//   Windows: VirtualAlloc con MEM_LARGE_PAGES (requiere el privilegio "Bloquear páginas en
+//            memoria" para el usuario), si no, VirtualAlloc normal.
+//   Linux:   mmap con MAP_HUGETLB (páginas reservadas en /proc/sys/vm/nr_hugepages), si no,
+//            mmap alineado a 2 MB con madvise(MADV_HUGEPAGE) para las páginas transparentes.
+// Kind() dice qué se consiguió y ResidentHugeBytes() cuánto quedó realmente en páginas grandes.
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+enum LargePageKind
+{
+	PAGES_NORMAL,		// Páginas de 4 KB
+	PAGES_TRANSPARENT,	// Se pidieron páginas grandes transparentes; el kernel decide
+	PAGES_EXPLICIT		// Páginas grandes reservadas explícitamente
+};
+
+inline const char* LargePageKindName(LargePageKind kind)
+{
+	switch (kind)
+	{
+	case PAGES_EXPLICIT: return "grandes";
+	case PAGES_TRANSPARENT: return "grandes transparentes";
+	default: return "normales";
+	}
+}
+
+class LargePageMemory
+{
+public:
+	static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+	LargePageMemory() {}
+
+	~LargePageMemory()
+	{
+		this->Free();
+	}
+
+	LargePageMemory(const LargePageMemory&) = delete;
+	LargePageMemory& operator=(const LargePageMemory&) = delete;
+
+	// Reserva al menos bytes bytes. La memoria no se toca aquí: ver ClearMemory.
+	bool Allocate(size_t bytes)
+	{
+		this->Free();
+		if (bytes == 0)
+		{
+			return false;
+		}
+#ifdef _WIN32
+		size_t largePage = GetLargePageMinimum();
+		if (largePage != 0 && enableLockMemoryPrivilege())
+		{
+			size_t rounded = (bytes + largePage - 1) / largePage * largePage;
+			this->data = VirtualAlloc(nullptr, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+			if (this->data != nullptr)
+			{
+				this->size = rounded;
+				this->kind = PAGES_EXPLICIT;
+				return true;
+			}
+		}
+		this->data = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+		if (this->data == nullptr)
+		{
+			return false;
+		}
+		this->size = bytes;
+		this->kind = PAGES_NORMAL;
+#else
+		size_t rounded = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+		void* huge = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (huge != MAP_FAILED)
+		{
+			this->data = huge;
+			this->size = rounded;
+			this->kind = PAGES_EXPLICIT;
+			return true;
+		}
+#endif
+		// Se reserva de más y se recortan los extremos para que el bloque empiece en un múltiplo de 2 MB
+		size_t padded = rounded + HUGE_PAGE_SIZE;
+		void* raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (raw == MAP_FAILED)
+		{
+			return false;
+		}
+		uintptr_t start = (uintptr_t)raw;
+		uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+		if (aligned > start)
+		{
+			munmap(raw, aligned - start);
+		}
+		if (start + padded > aligned + rounded)
+		{
+			munmap((void*)(aligned + rounded), start + padded - (aligned + rounded));
+		}
+		this->data = (void*)aligned;
+		this->size = rounded;
+		this->kind = PAGES_NORMAL;
+#ifdef MADV_HUGEPAGE
+		if (madvise(this->data, rounded, MADV_HUGEPAGE) == 0)
+		{
+			this->kind = PAGES_TRANSPARENT;
+		}
+#endif
+#endif
+		return this->data != nullptr;
+	}
+
+	void Free()
+	{
+		if (this->data == nullptr)
+		{
+			return;
+		}
+#ifdef _WIN32
+		VirtualFree(this->data, 0, MEM_RELEASE);
+#else
+		munmap(this->data, this->size);
+#endif
+		this->data = nullptr;
+		this->size = 0;
+		this->kind = PAGES_NORMAL;
+	}
+
+	void* Data() const
+	{
+		return this->data;
+	}
+
+	size_t Size() const
+	{
+		return this->size;
+	}
+
+	LargePageKind Kind() const
+	{
+		return this->kind;
+	}
+
+	// Bytes del bloque que están en páginas grandes ahora mismo, o -1 si no se puede saber.
+	// Con páginas transparentes el kernel puede negarlas aunque madvise haya funcionado.
+	long long ResidentHugeBytes() const
+	{
+		if (this->data == nullptr)
+		{
+			return 0;
+		}
+		if (this->kind == PAGES_EXPLICIT)
+		{
+			return (long long)this->size;
+		}
+#ifdef __linux__
+		// En /proc/self/smaps cada región empieza con "inicio-fin permisos ..." y trae un campo AnonHugePages
+		std::ifstream smaps("/proc/self/smaps");
+		std::string line;
+		long long total = 0;
+		bool inside = false;
+		uintptr_t blockStart = (uintptr_t)this->data, blockEnd = blockStart + this->size;
+		while (std::getline(smaps, line))
+		{
+			unsigned long long start, end;
+			char dash;
+			std::istringstream fields(line);
+			if (line.find('-') < line.find(' ') && fields >> std::hex >> start >> dash >> end)
+			{
+				inside = start < blockEnd && end > blockStart;
+				continue;
+			}
+			if (inside && line.compare(0, 14, "AnonHugePages:") == 0)
+			{
+				std::istringstream value(line.substr(14));
+				long long kilobytes = 0;
+				value >> kilobytes;
+				total += kilobytes * 1024;
+			}
+		}
+		return total;
+#else
+		return -1;
+#endif
+	}
+
+private:
+	void* data = nullptr;
+	size_t size = 0;
+	LargePageKind kind = PAGES_NORMAL;
+
+#ifdef _WIN32
+	static bool enableLockMemoryPrivilege()
+	{
+		HANDLE token;
+		if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+		{
+			return false;
+		}
+		TOKEN_PRIVILEGES privileges;
+		privileges.PrivilegeCount = 1;
+		privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+		bool enabled = LookupPrivilegeValue(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+			AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+			GetLastError() == ERROR_SUCCESS;
+		CloseHandle(token);
+		return enabled;
+	}
+#endif
+};
+
+// Reserva en memory una tabla de entradas de entrySize bytes con un número de entradas
+// potencia de dos: la más grande que quepa en megabytes. Si el sistema no da esa memoria se
+// prueba con la mitad, y así hasta una entrada; la reducción se informa una vez como
+// ERROR::<module>::... Devuelve el número de entradas reservadas, 0 si no se pudo ni una.
+inline size_t AllocateTable(LargePageMemory& memory, size_t megabytes, size_t entrySize, const char* module)
+{
+	size_t requested = 1;
+	while (requested * 2 * entrySize <= megabytes * 1024 * 1024)
+	{
+		requested *= 2;
+	}
+	size_t count = requested;
+	while (count > 0 && !memory.Allocate(count * entrySize))
+	{
+		count /= 2;
+	}
+	if (count == 0)
+	{
+		std::cerr << "ERROR::" << module << "::SIN_MEMORIA no se pudo reservar la tabla de " << megabytes << " MB" << std::endl;
+	}
+	else if (count < requested)
+	{
+		std::cerr << "ERROR::" << module << "::TABLA_REDUCIDA se pidieron " << requested * entrySize << " bytes y se reservaron "
+			<< count * entrySize << std::endl;
+	}
+	return count;
+}
+
+// Llena de ceros un bloque. Con varios hilos cada uno escribe su parte: la primera escritura
+// de una página decide en qué nodo NUMA queda, así que una tabla compartida limpiada con
+// tantos hilos como los que la van a usar queda repartida entre los nodos en lugar de
+// quedar completa en el nodo del hilo principal.
+inline void ClearMemory(void* data, size_t bytes, int numThreads)
+{
+	if (numThreads <= 1 || bytes < (size_t)numThreads * LargePageMemory::HUGE_PAGE_SIZE)
+	{
+		std::memset(data, 0, bytes);
+		return;
+	}
+	size_t pages = (bytes + LargePageMemory::HUGE_PAGE_SIZE - 1) / LargePageMemory::HUGE_PAGE_SIZE;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < numThreads; t++)
+	{
+		size_t begin = pages * t / numThreads * LargePageMemory::HUGE_PAGE_SIZE;
+		size_t end = std::min(bytes, pages * (t + 1) / numThreads * LargePageMemory::HUGE_PAGE_SIZE);
+		threads.emplace_back([=]() {
+			std::memset((char*)data + begin, 0, end - begin);
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
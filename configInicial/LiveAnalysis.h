@@ -0,0 +1,142 @@
+#pragma once
+
+// Análisis continuo de la posición de la ventana en un hilo aparte.
+// La búsqueda corre sin límite con MultiPV; al terminar cada profundidad deja una copia del
+// resultado que la ventana recoge con TakeUpdate para redibujar las flechas, sin esperar
+// nunca a la búsqueda. El hilo es uno solo y dura lo que el objeto: Start y Stop solo dejan
+// el pedido y levantan la bandera de parada, así que tampoco esperan a que la búsqueda
+// anterior termine.
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "ChessRules.h"
+#include "Search.h"
+
+class LiveAnalysis
+{
+public:
+	// La tabla se reserva al empezar el primer análisis, no al crear el objeto
+	explicit LiveAnalysis(size_t ttMegabytes = 64) : ttMegabytes(ttMegabytes) {}
+
+	~LiveAnalysis()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->quit = true;
+			this->stop = true;
+		}
+		this->wake.notify_one();
+		if (this->worker.joinable())
+		{
+			this->worker.join();
+		}
+	}
+
+	LiveAnalysis(const LiveAnalysis&) = delete;
+	LiveAnalysis& operator=(const LiveAnalysis&) = delete;
+
+	// Empieza (o reinicia) el análisis de pos con multiPV líneas. No espera a la búsqueda
+	// anterior: se le pide que se detenga y el hilo empieza la nueva en cuanto termina.
+	void Start(const Position& pos, int multiPV)
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->requested = pos;
+			this->requestedLines = multiPV;
+			this->pending = true;
+			this->generation++;
+			this->stop = true;
+			this->fresh = false;
+		}
+		if (!this->worker.joinable())
+		{
+			this->worker = std::thread([this]() { this->run(); });
+		}
+		this->wake.notify_one();
+	}
+
+	// Detiene el análisis sin esperar: los resultados de la búsqueda que sigue terminando se descartan
+	void Stop()
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->pending = false;
+		this->generation++;
+		this->stop = true;
+		this->fresh = false;
+	}
+
+	// Deja en result la última profundidad terminada si llegó una nueva desde la llamada
+	// anterior. Se intercambia en lugar de copiarse: la ventana no reserva memoria para las
+	// variantes y la búsqueda reutiliza los búferes viejos de result en la siguiente copia.
+	bool TakeUpdate(SearchResult& result)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (!this->fresh)
+		{
+			return false;
+		}
+		std::swap(result, this->latest);
+		this->fresh = false;
+		return true;
+	}
+
+private:
+	size_t ttMegabytes;
+	std::unique_ptr<Searcher> searcher;	// Solo la usa el hilo
+	std::thread worker;
+	std::atomic<bool> stop{ false };
+
+	std::mutex mutex;		// Protege todo lo de abajo
+	std::condition_variable wake;
+	Position requested;		// Posición del próximo análisis
+	int requestedLines = 1;
+	bool pending = false;	// Hay un análisis pedido que el hilo todavía no empezó
+	bool quit = false;
+	uint64_t generation = 0;	// Cambia con cada Start o Stop; invalida los resultados de búsquedas viejas
+	SearchResult latest;
+	bool fresh = false;
+
+	// Hilo que vive mientras exista el objeto: espera un pedido, lo busca hasta que lo
+	// detengan y vuelve a esperar
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		while (true)
+		{
+			this->wake.wait(lock, [this]() { return this->pending || this->quit; });
+			if (this->quit)
+			{
+				return;
+			}
+			Position pos = this->requested;
+			uint64_t searchGeneration = this->generation;
+			SearchLimits limits;
+			limits.stop = &this->stop;
+			limits.multiPV = this->requestedLines;
+			limits.onIteration = [this, searchGeneration](const SearchResult& result) {
+				std::lock_guard<std::mutex> lock(this->mutex);
+				if (this->generation != searchGeneration)
+				{
+					return; // Llegó un Start o un Stop después de empezar esta búsqueda
+				}
+				this->latest = result;
+				this->fresh = true;
+			};
+			this->pending = false;
+			this->stop = false;
+			lock.unlock();
+
+			if (!this->searcher)
+			{
+				this->searcher.reset(new Searcher(this->ttMegabytes));
+			}
+			this->searcher->Search(pos, limits);
+			lock.lock();
+		}
+	}
+};
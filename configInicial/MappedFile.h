@@ -0,0 +1,134 @@
+#pragma once
+
+// Archivo de solo lectura proyectado en memoria.
+// Se usa para los archivos binarios de partidas: abrirlos no copia nada y el sistema
+// operativo solo carga las páginas que realmente se leen.
+
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+class MappedFile
+{
+public:
+	MappedFile() {}
+
+	~MappedFile()
+	{
+		this->Close();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& path)
+	{
+		this->Close();
+#ifdef _WIN32
+		this->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (this->file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(this->file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			this->Close();
+			return false;
+		}
+		this->mapping = CreateFileMappingA(this->file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (this->mapping == NULL)
+		{
+			this->Close();
+			return false;
+		}
+		this->bytes = (const unsigned char*)MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+		this->length = (size_t)fileSize.QuadPart;
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+		struct stat info;
+		if (fstat(fd, &info) != 0 || info.st_size == 0)
+		{
+			close(fd);
+			return false;
+		}
+		void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (view == MAP_FAILED)
+		{
+			return false;
+		}
+		this->bytes = (const unsigned char*)view;
+		this->length = (size_t)info.st_size;
+#endif
+		if (this->bytes == nullptr)
+		{
+			this->Close();
+			return false;
+		}
+		return true;
+	}
+
+	void Close()
+	{
+#ifdef _WIN32
+		if (this->bytes != nullptr)
+		{
+			UnmapViewOfFile(this->bytes);
+		}
+		if (this->mapping != NULL)
+		{
+			CloseHandle(this->mapping);
+			this->mapping = NULL;
+		}
+		if (this->file != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(this->file);
+			this->file = INVALID_HANDLE_VALUE;
+		}
+#else
+		if (this->bytes != nullptr)
+		{
+			munmap((void*)this->bytes, this->length);
+		}
+#endif
+		this->bytes = nullptr;
+		this->length = 0;
+	}
+
+	const unsigned char* Data() const
+	{
+		return this->bytes;
+	}
+
+	size_t Size() const
+	{
+		return this->length;
+	}
+
+private:
+	const unsigned char* bytes = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+#endif
+};
@@ -0,0 +1,315 @@
+#pragma once
+
+// Partidas motor contra motor para comprobar que un cambio no pierde fuerza.
+// Se enfrentan dos configuraciones del buscador (A y B) en varias partidas a la vez, una por
+// hilo. Cada apertura se juega dos veces con los colores cambiados para que la ventaja de
+// salida se compense. Tras cada partida se actualiza una prueba SPRT (razón de
+// verosimilitudes secuencial) entre las hipótesis "A es elo0 mejor que B" y "A es elo1
+// mejor que B"; cuando la razón cruza uno de los límites el match se detiene.
+//
+// Una configuración se escribe como un número de nodos por jugada ("20000") o como una
+// profundidad fija ("d4").
+//
+// Uso: configInicial.exe --match A B partidas [hilos] [aperturas.epd]
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <unordered_map>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+#include "ChessRules.h"
+#include "Search.h"
+
+const double SPRT_ELO0 = 0.0;
+const double SPRT_ELO1 = 10.0;
+const double SPRT_ALPHA = 0.05;				// Probabilidad de aceptar H1 si es cierta H0
+const double SPRT_BETA = 0.05;				// Probabilidad de aceptar H0 si es cierta H1
+const int MATCH_MAX_PLIES = 300;			// Tablas si la partida llega a esta longitud
+const int MATCH_RANDOM_PLIES = 6;			// Longitud de las aperturas generadas si no hay archivo
+const int MATCH_REPORT_INTERVAL = 10;		// Partidas entre informes de progreso
+const size_t MATCH_TABLE_MB = 8;
+
+struct EngineConfig
+{
+	std::string name;
+	uint64_t nodes = 0;
+	int maxDepth = MAX_PLY - 1;
+};
+
+// "20000" = nodos por jugada, "d4" = profundidad fija. Devuelve false si no se entiende.
+inline bool ParseEngineConfig(const std::string& text, EngineConfig& config)
+{
+	config = EngineConfig();
+	config.name = text;
+	char* end = nullptr;
+	if (!text.empty() && (text[0] == 'd' || text[0] == 'D'))
+	{
+		config.maxDepth = (int)std::strtol(text.c_str() + 1, &end, 10);
+		return *end == '\0' && config.maxDepth > 0 && config.maxDepth < MAX_PLY;
+	}
+	config.nodes = std::strtoull(text.c_str(), &end, 10);
+	return !text.empty() && *end == '\0' && config.nodes > 0;
+}
+
+// Partidas ganadas, empatadas y perdidas por A, con la estimación de Elo y la prueba SPRT
+struct MatchScore
+{
+	int wins = 0;
+	int draws = 0;
+	int losses = 0;
+
+	int Games() const
+	{
+		return this->wins + this->draws + this->losses;
+	}
+
+	// Puntuación media de A y su varianza por partida
+	void Moments(double& mean, double& variance) const
+	{
+		// Media partida de más en cada resultado para que la varianza no sea cero al principio
+		double w = this->wins + 0.5, d = this->draws + 0.5, l = this->losses + 0.5;
+		double n = w + d + l;
+		mean = (w + 0.5 * d) / n;
+		variance = (w * (1.0 - mean) * (1.0 - mean) + d * (0.5 - mean) * (0.5 - mean) + l * mean * mean) / n;
+	}
+
+	static double ScoreToElo(double score)
+	{
+		score = std::min(std::max(score, 1e-6), 1.0 - 1e-6);
+		return -400.0 * std::log10(1.0 / score - 1.0);
+	}
+
+	static double EloToScore(double elo)
+	{
+		return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+	}
+
+	// Elo de A sobre B y la mitad del intervalo de confianza del 95%
+	double Elo(double& margin) const
+	{
+		double mean, variance;
+		this->Moments(mean, variance);
+		double error = 1.96 * std::sqrt(variance / this->Games());
+		margin = (ScoreToElo(mean + error) - ScoreToElo(mean - error)) / 2.0;
+		return ScoreToElo(mean);
+	}
+
+	// Logaritmo de la razón de verosimilitudes de H1 contra H0 (aproximación normal)
+	double LLR() const
+	{
+		double mean, variance;
+		this->Moments(mean, variance);
+		double s0 = EloToScore(SPRT_ELO0), s1 = EloToScore(SPRT_ELO1);
+		return this->Games() * (s1 - s0) * (2.0 * mean - s0 - s1) / (2.0 * variance);
+	}
+};
+
+// Juega una partida desde start. Devuelve 1 si ganan las blancas, -1 si ganan las negras y 0 si
+// hay tablas (ahogado, triple repetición o MATCH_MAX_PLIES).
+inline int PlayMatchGame(const Position& start, Searcher& white, const EngineConfig& whiteConfig,
+	Searcher& black, const EngineConfig& blackConfig)
+{
+	white.Hash().Clear();
+	black.Hash().Clear();
+	Position pos = start;
+	std::unordered_map<uint64_t, int> repetitions;
+	MoveUndo undo;
+	for (int ply = 0; ply < MATCH_MAX_PLIES; ply++)
+	{
+		if (++repetitions[PositionKey(pos)] >= 3)
+		{
+			return 0;
+		}
+		bool whiteToMove = pos.sideToMove == WHITE;
+		const EngineConfig& config = whiteToMove ? whiteConfig : blackConfig;
+		SearchLimits limits;
+		limits.nodes = config.nodes;
+		limits.maxDepth = config.maxDepth;
+		SearchResult result = (whiteToMove ? white : black).Search(pos, limits);
+		if (result.bestMove.fromRow < 0)
+		{
+			// Sin jugadas: mate si está en jaque, ahogado si no
+			return !IsInCheck(pos) ? 0 : whiteToMove ? -1 : 1;
+		}
+		MakeMove(pos, result.bestMove, undo);
+	}
+	return 0;
+}
+
+// Aperturas del archivo EPD (cuatro primeros campos de cada línea) o, si no hay archivo,
+// count aperturas de MATCH_RANDOM_PLIES jugadas al azar con semilla fija
+inline bool LoadMatchOpenings(const std::string& path, size_t count, std::vector<Position>& openings)
+{
+	openings.clear();
+	if (!path.empty())
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			return false;
+		}
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::istringstream stream(line);
+			std::string fields[4];
+			for (std::string& field : fields)
+			{
+				stream >> field;
+			}
+			Position pos;
+			if (!fields[0].empty() && LoadFEN(pos, fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3]))
+			{
+				openings.push_back(pos);
+			}
+		}
+		return !openings.empty();
+	}
+
+	std::vector<ChessMove> moves;
+	MoveUndo undo;
+	for (size_t i = 0; i < count; i++)
+	{
+		std::mt19937 random((uint32_t)i);
+		Position pos;
+		LoadFEN(pos, START_FEN);
+		for (int ply = 0; ply < MATCH_RANDOM_PLIES; ply++)
+		{
+			GenerateMoves(pos, moves);
+			if (moves.empty())
+			{
+				break;
+			}
+			MakeMove(pos, moves[random() % moves.size()], undo);
+		}
+		openings.push_back(pos);
+	}
+	return true;
+}
+
+inline int RunMatch(const std::string& specA, const std::string& specB, int maxGames, int numThreads,
+	const std::string& openingsPath, std::ostream& out)
+{
+	EngineConfig configs[2];
+	if (!ParseEngineConfig(specA, configs[0]) || !ParseEngineConfig(specB, configs[1]))
+	{
+		std::cerr << "ERROR::MATCH::CONFIGURACION_INVALIDA " << specA << " " << specB << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::vector<Position> openings;
+	if (!LoadMatchOpenings(openingsPath, (size_t)(maxGames + 1) / 2, openings))
+	{
+		std::cerr << "ERROR::MATCH::NO_SE_PUDO_ABRIR " << openingsPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (numThreads <= 0)
+	{
+		numThreads = (int)std::thread::hardware_concurrency();
+		if (numThreads <= 0)
+		{
+			numThreads = 1;
+		}
+	}
+
+	double lowerBound = std::log(SPRT_BETA / (1.0 - SPRT_ALPHA));
+	double upperBound = std::log((1.0 - SPRT_BETA) / SPRT_ALPHA);
+	std::mutex mutex;			// Protege score y la salida
+	MatchScore score;
+	std::atomic<int> nextGame{ 0 };
+	std::atomic<bool> decided{ false };
+	double decisionLLR = 0.0;	// LLR al cruzar un límite; las partidas que ya estaban en curso no la cambian
+	auto start = std::chrono::steady_clock::now();
+
+	auto report = [&](double llr) {
+		double margin;
+		double elo = score.Elo(margin);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		out << "Partidas " << score.Games() << ": +" << score.wins << " =" << score.draws << " -" << score.losses
+			<< "  Elo " << std::fixed << std::setprecision(1) << elo << " +/- " << margin << "  LLR " << std::setprecision(2)
+			<< llr << " [" << lowerBound << ", " << upperBound << "]  " << std::setprecision(1)
+			<< (seconds > 0.0 ? score.Games() / seconds : 0.0) << " partidas/s" << std::endl;
+	};
+
+	// Cada hilo juega sus partidas con su propio par de Searcher hasta que se acaban o hay decisión
+	std::vector<std::thread> threads;
+	for (int t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&]() {
+			Searcher searcherA(MATCH_TABLE_MB), searcherB(MATCH_TABLE_MB);
+			Searcher* searchers[2] = { &searcherA, &searcherB };
+			for (;;)
+			{
+				int game = nextGame++;
+				if (game >= maxGames || decided)
+				{
+					break;
+				}
+				// Cada apertura dos veces: en las partidas pares A lleva blancas
+				const Position& opening = openings[(size_t)(game / 2) % openings.size()];
+				int a = game % 2;
+				int whiteResult = PlayMatchGame(opening, *searchers[a], configs[a], *searchers[1 - a], configs[1 - a]);
+				int resultA = (a == 0) ? whiteResult : -whiteResult;
+
+				std::lock_guard<std::mutex> lock(mutex);
+				if (resultA > 0)
+				{
+					score.wins++;
+				}
+				else if (resultA < 0)
+				{
+					score.losses++;
+				}
+				else
+				{
+					score.draws++;
+				}
+				double llr = score.LLR();
+				if (!decided && (llr <= lowerBound || llr >= upperBound))
+				{
+					decided = true;
+					decisionLLR = llr;
+				}
+				if (score.Games() % MATCH_REPORT_INTERVAL == 0)
+				{
+					report(llr);
+				}
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	if (score.Games() % MATCH_REPORT_INTERVAL != 0)
+	{
+		report(score.LLR());
+	}
+	double llr = decided ? decisionLLR : score.LLR();
+	out << configs[0].name << " contra " << configs[1].name << ": ";
+	if (llr >= upperBound)
+	{
+		out << "H1 aceptada (" << configs[0].name << " es al menos " << SPRT_ELO1 << " Elo mejor)" << std::endl;
+	}
+	else if (llr <= lowerBound)
+	{
+		out << "H0 aceptada (" << configs[0].name << " no es mejor que " << configs[1].name << ")" << std::endl;
+	}
+	else
+	{
+		out << "sin decision tras " << score.Games() << " partidas" << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,414 @@
+#pragma once
+
+// Buscador de mates con df-pn (búsqueda de números de prueba en profundidad).
+// En lugar de recorrer el árbol a una profundidad fija como alfa-beta, cada nodo lleva dos
+// números: cuántos nodos faltan como mínimo para probar el mate (número de prueba) y para
+// refutarlo (número de refutación). Siempre se expande el camino más barato de probar, así
+// que las defensas forzadas se siguen muy lejos y las variantes sin salida se abandonan pronto.
+//
+// "Mate en N" quiere decir que, hagan lo que hagan las defensas, después de la jugada N del
+// bando que mueve (jugada 2N-1 del árbol) el rival queda sin jugadas legales y en jaque.
+// Un ahogado salva al defensor.
+//
+// Los nodos se guardan en una tabla de transposición propia indexada por (posición, jugadas
+// restantes). Se prueba mate en 1, 2, ... hasta maxMoves, así que el primer mate encontrado
+// es el más corto.
+//
+// Uso: configInicial.exe --mate-suite problemas.epd [MB de tabla] [nodos máximos por problema]
+//      Cada línea EPD debe traer la operación "dm N" (mate en N).
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include "ChessRules.h"
+#include "LargePages.h"
+
+struct MateResult
+{
+	bool proven = false;
+	int mateIn = 0;					// Número de jugadas del bando que da mate
+	std::vector<ChessMove> pv;		// Una línea del mate (la defensa elegida es una de las forzadas)
+	uint64_t nodes = 0;
+	bool aborted = false;			// Se acabó el límite de nodos antes de decidir
+};
+
+class MateSolver
+{
+public:
+	static const uint32_t INFINITE_NUMBER = 0x3FFFFFFF;
+
+	explicit MateSolver(size_t megabytes)
+	{
+		size_t count = AllocateTable(this->memory, megabytes, sizeof(Entry), "MATE");
+		this->entries = (count > 0) ? (Entry*)this->memory.Data() : &this->fallback;
+		this->mask = (count > 0) ? count - 1 : 0;
+		this->clear();
+	}
+
+	// Busca mate para el bando que mueve en pos en a lo más maxMoves jugadas
+	MateResult Solve(const Position& root, int maxMoves, uint64_t maxNodes = 0)
+	{
+		MateResult result;
+		this->clear();
+		this->nodes = 0;
+		this->maxNodes = maxNodes;
+		this->aborted = false;
+		this->pos = root;
+		uint64_t key = PositionKey(root);
+		if (this->plyMoves.size() < (size_t)(2 * maxMoves + 1))
+		{
+			this->plyMoves.resize(2 * maxMoves + 1);
+			this->plyChildren.resize(2 * maxMoves + 1);
+		}
+
+		for (int moves = 1; moves <= maxMoves && !this->aborted; moves++)
+		{
+			uint32_t phi, delta;
+			this->mid(key, 2 * moves, true, INFINITE_NUMBER, INFINITE_NUMBER, phi, delta);
+			if (!this->aborted && phi == 0)
+			{
+				result.proven = true;
+				result.mateIn = moves;
+				this->extractLine(key, 2 * moves, result.pv);
+				break;
+			}
+		}
+		result.nodes = this->nodes;
+		result.aborted = this->aborted;
+		return result;
+	}
+
+	size_t TableBytes() const
+	{
+		return (this->mask + 1) * sizeof(Entry);
+	}
+
+	// Bytes de una entrada de la tabla
+	static size_t EntryBytes()
+	{
+		return sizeof(Entry);
+	}
+
+	// Entradas de la tabla ocupadas desde el último Solve
+	size_t UsedEntries() const
+	{
+		return this->used;
+	}
+
+	size_t TableEntries() const
+	{
+		return this->mask + 1;
+	}
+
+	const LargePageMemory& Memory() const
+	{
+		return this->memory;
+	}
+
+private:
+	// phi y delta son los números del bando que mueve en el nodo: phi = costo de probar que
+	// gana, delta = costo de probar que no. En los nodos del atacante phi es el número de
+	// prueba y delta el de refutación; en los del defensor es al revés.
+	struct Entry
+	{
+		uint64_t key;
+		uint32_t phi;
+		uint32_t delta;
+	};
+
+	struct Child
+	{
+		ChessMove move;
+		uint64_t key;
+	};
+
+	LargePageMemory memory;
+	Entry* entries = nullptr;
+	size_t mask = 0;
+	// Entrada única para cuando AllocateTable no consigue memoria
+	Entry fallback;
+	size_t used = 0;
+	// Jugadas e hijos de cada nodo abierto, por jugadas restantes: a lo largo de una rama
+	// remaining baja de uno en uno, así que cada nivel tiene el suyo y, pasada la primera
+	// vez que crecen, mid no reserva memoria
+	std::vector<std::vector<ChessMove>> plyMoves;
+	std::vector<std::vector<Child>> plyChildren;
+	Position pos;
+	uint64_t nodes = 0;
+	uint64_t maxNodes = 0;
+	bool aborted = false;
+
+	void clear()
+	{
+		ClearMemory(this->entries, this->TableBytes(), 1);
+		this->used = 0;
+	}
+
+	// Clave de la tabla: la misma posición con distintas jugadas restantes es otro nodo
+	static uint64_t nodeKey(uint64_t key, int remaining)
+	{
+		return key ^ ((uint64_t)(remaining + 1) * 0x9E3779B97F4A7C15ull);
+	}
+
+	bool lookup(uint64_t key, uint32_t& phi, uint32_t& delta) const
+	{
+		const Entry& entry = this->entries[key & this->mask];
+		if (entry.key != key || (entry.phi == 0 && entry.delta == 0))
+		{
+			return false;
+		}
+		phi = entry.phi;
+		delta = entry.delta;
+		return true;
+	}
+
+	void store(uint64_t key, uint32_t phi, uint32_t delta)
+	{
+		Entry& entry = this->entries[key & this->mask];
+		if (entry.phi == 0 && entry.delta == 0)
+		{
+			this->used++;
+		}
+		entry.key = key;
+		entry.phi = phi;
+		entry.delta = delta;
+	}
+
+	// Números de un hijo sin expandirlo. attackerMoves dice a quién le toca en el hijo.
+	void childNumbers(const Child& child, int remaining, bool attackerMoves, uint32_t& phi, uint32_t& delta) const
+	{
+		if (remaining == 0)
+		{
+			// Sin jugadas restantes no hay mate: el atacante pierde y el defensor se salva
+			phi = attackerMoves ? INFINITE_NUMBER : 0;
+			delta = attackerMoves ? 0 : INFINITE_NUMBER;
+		}
+		else if (!this->lookup(nodeKey(child.key, remaining), phi, delta))
+		{
+			phi = 1;
+			delta = 1;
+		}
+	}
+
+	static uint32_t saturate(uint64_t value)
+	{
+		return (uint32_t)std::min<uint64_t>(value, INFINITE_NUMBER);
+	}
+
+	void mid(uint64_t key, int remaining, bool attackerMoves, uint32_t thPhi, uint32_t thDelta, uint32_t& phi, uint32_t& delta)
+	{
+		this->nodes++;
+		if (this->maxNodes != 0 && this->nodes >= this->maxNodes)
+		{
+			this->aborted = true;
+		}
+
+		std::vector<ChessMove>& moves = this->plyMoves[remaining];
+		GenerateMoves(this->pos, moves);
+		if (moves.empty())
+		{
+			// Sin jugadas: el atacante no puede dar mate y el defensor pierde solo si está en jaque
+			bool mated = !attackerMoves && IsInCheck(this->pos);
+			phi = (attackerMoves || mated) ? INFINITE_NUMBER : 0;
+			delta = (attackerMoves || mated) ? 0 : INFINITE_NUMBER;
+			this->store(nodeKey(key, remaining), phi, delta);
+			return;
+		}
+
+		std::vector<Child>& children = this->plyChildren[remaining];
+		children.resize(moves.size());
+		for (size_t i = 0; i < moves.size(); i++)
+		{
+			children[i].move = moves[i];
+			children[i].key = KeyAfterMove(key, this->pos, moves[i]);
+		}
+
+		MoveUndo undo;
+		for (;;)
+		{
+			// phi = mínimo de los delta de los hijos, delta = suma de sus phi
+			uint64_t deltaSum = 0;
+			uint32_t bestDelta = INFINITE_NUMBER, secondDelta = INFINITE_NUMBER, bestPhi = INFINITE_NUMBER;
+			size_t best = 0;
+			for (size_t i = 0; i < children.size(); i++)
+			{
+				uint32_t childPhi, childDelta;
+				this->childNumbers(children[i], remaining - 1, !attackerMoves, childPhi, childDelta);
+				deltaSum += childPhi;
+				if (childDelta < bestDelta)
+				{
+					secondDelta = bestDelta;
+					bestDelta = childDelta;
+					bestPhi = childPhi;
+					best = i;
+				}
+				else if (childDelta < secondDelta)
+				{
+					secondDelta = childDelta;
+				}
+			}
+			phi = bestDelta;
+			delta = saturate(deltaSum);
+			if (phi >= thPhi || delta >= thDelta || this->aborted)
+			{
+				break;
+			}
+
+			// Umbrales del hijo elegido: puede trabajar hasta que deje de ser el mejor
+			// (delta2 + 1) o hasta que la suma del padre pase su umbral
+			uint32_t childThPhi = (thDelta >= INFINITE_NUMBER) ? INFINITE_NUMBER : saturate((uint64_t)thDelta - delta + bestPhi);
+			uint32_t childThDelta = std::min<uint32_t>(thPhi, saturate((uint64_t)secondDelta + 1));
+
+			const Child& child = children[best];
+			uint32_t childPhi, childDelta;
+			MakeMove(this->pos, child.move, undo);
+			this->mid(child.key, remaining - 1, !attackerMoves, childThPhi, childThDelta, childPhi, childDelta);
+			UnmakeMove(this->pos, child.move, undo);
+		}
+		this->store(nodeKey(key, remaining), phi, delta);
+	}
+
+	// Recorre la prueba guardada en la tabla: el atacante elige un hijo probado y el defensor
+	// una de sus jugadas (todas pierden). La línea termina con la jugada de mate.
+	void extractLine(uint64_t key, int remaining, std::vector<ChessMove>& line)
+	{
+		Position walk = this->pos;
+		MoveUndo undo;
+		bool attackerMoves = true;
+		std::vector<ChessMove> moves;
+		while (remaining > 1)
+		{
+			GenerateMoves(walk, moves);
+			bool found = false;
+			for (const ChessMove& move : moves)
+			{
+				Child child;
+				child.move = move;
+				child.key = KeyAfterMove(key, walk, move);
+				uint32_t childPhi, childDelta;
+				this->childNumbers(child, remaining - 1, !attackerMoves, childPhi, childDelta);
+				// Hijo donde el atacante gana: delta = 0 si mueve el defensor, phi = 0 si mueve el atacante
+				if ((attackerMoves && childDelta != 0) || (!attackerMoves && childPhi != 0))
+				{
+					continue;
+				}
+				MakeMove(walk, move, undo);
+				line.push_back(move);
+				key = child.key;
+				found = true;
+				break;
+			}
+			if (!found)
+			{
+				return; // La tabla perdió esa parte de la prueba
+			}
+			remaining--;
+			attackerMoves = !attackerMoves;
+		}
+	}
+};
+
+// Resuelve todos los problemas de una suite EPD con "dm N" e informa tiempo y memoria
+inline int RunMateSuite(const std::string& path, size_t megabytes, uint64_t maxNodes, std::ostream& out)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cerr << "ERROR::MATE::NO_SE_PUDO_ABRIR " << path << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	MateSolver solver(megabytes);
+	int puzzles = 0, solved = 0, invalid = 0;
+	uint64_t totalNodes = 0;
+	double totalSeconds = 0.0, worstSeconds = 0.0;
+	size_t peakEntries = 0;
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream stream(line);
+		std::string fields[4];
+		for (std::string& field : fields)
+		{
+			stream >> field;
+		}
+		if (fields[0].empty())
+		{
+			continue;
+		}
+		std::string operations, op, id;
+		std::getline(stream, operations);
+		std::istringstream opStream(operations);
+		int mateIn = 0;
+		while (std::getline(opStream, op, ';'))
+		{
+			std::istringstream opFields(op);
+			std::string opcode;
+			opFields >> opcode;
+			if (opcode == "dm")
+			{
+				opFields >> mateIn;
+			}
+			else if (opcode == "id")
+			{
+				std::getline(opFields >> std::ws, id);
+			}
+		}
+
+		puzzles++;
+		Position pos;
+		if (mateIn <= 0 || !LoadFEN(pos, fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3]))
+		{
+			invalid++;
+			out << puzzles << "\tlinea invalida (falta FEN o \"dm N\")" << std::endl;
+			continue;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		MateResult result = solver.Solve(pos, mateIn, maxNodes);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		totalSeconds += seconds;
+		worstSeconds = std::max(worstSeconds, seconds);
+		totalNodes += result.nodes;
+		peakEntries = std::max(peakEntries, solver.UsedEntries());
+
+		out << puzzles << "\t";
+		if (result.proven)
+		{
+			solved++;
+			out << "mate en " << result.mateIn << "\t";
+			for (const ChessMove& move : result.pv)
+			{
+				out << MoveToString(move) << " ";
+			}
+		}
+		else
+		{
+			out << (result.aborted ? "sin decidir (limite de nodos)" : "sin mate") << "\t";
+		}
+		out << "\t" << std::fixed << std::setprecision(1) << seconds * 1000.0 << " ms\t" << result.nodes << " nodos\t"
+			<< (solver.UsedEntries() * MateSolver::EntryBytes() >> 10) << " KB de tabla";
+		if (!id.empty())
+		{
+			out << "\t" << id;
+		}
+		out << std::endl;
+	}
+
+	std::cerr << "Problemas: " << puzzles << "  resueltos: " << solved << "  invalidos: " << invalid << std::endl;
+	std::cerr << "Tiempo: " << std::fixed << std::setprecision(3) << totalSeconds << " s  (peor " << worstSeconds * 1000.0
+		<< " ms, " << std::setprecision(0) << (totalSeconds > 0.0 ? totalNodes / totalSeconds : 0.0) << " nodos/s)" << std::endl;
+	std::cerr << "Tabla: " << (solver.TableBytes() >> 20) << " MB en paginas " << LargePageKindName(solver.Memory().Kind())
+		<< ", uso maximo " << peakEntries << " de " << solver.TableEntries() << " entradas ("
+		<< std::setprecision(1) << 100.0 * peakEntries / solver.TableEntries() << "%)" << std::endl;
+	return (solved == puzzles) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
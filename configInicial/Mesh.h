@@ -16,19 +16,10 @@
 
 
 #include "Shader.h"
+#include "GeometryPool.h"
 
 using namespace std;
 
-struct Vertex
-{
-	// Position
-	glm::vec3 Position;
-	// Normal
-	glm::vec3 Normal;
-	// TexCoords
-	glm::vec2 TexCoords;
-};
-
 struct Texture
 {
 	GLuint id;
@@ -56,88 +47,116 @@ public:
 		this->setupMesh();
 	}
 
-	// Render the mesh
-	void Draw(Shader shader)
+	// Resuelve una sola vez los samplers y uniforms de material de la malla para el programa de
+	// shader: qué textura va en cada unidad y en qué localidad se indica. Así Draw no construye
+	// nombres ni busca nada en cada cuadro. Las texturas que el shader no lee no se enlazan (el
+	// shader instanciado lee las pieles de PieceSkinArray, no las de cada malla).
+	void Bake(const Shader& shader)
 	{
-		// Bind appropriate textures
 		GLuint diffuseNr = 1;
 		GLuint specularNr = 1;
-
+		this->bindings.clear();
 		for (GLuint i = 0; i < this->textures.size(); i++)
 		{
-			glActiveTexture(GL_TEXTURE0 + i); // Active proper texture unit before binding
-											  // Retrieve texture number (the N in diffuse_textureN)
-			stringstream ss;
-			string number;
+			// Retrieve texture number (the N in diffuse_textureN)
 			string name = this->textures[i].type;
-
+			string number;
 			if (name == "texture_diffuse")
 			{
-				ss << diffuseNr++; // Transfer GLuint to stream
+				number = std::to_string(diffuseNr++);
 			}
 			else if (name == "texture_specular")
 			{
-				ss << specularNr++; // Transfer GLuint to stream
+				number = std::to_string(specularNr++);
 			}
 
-			number = ss.str();
-			// Now set the sampler to the correct texture unit
-			glUniform1i(glGetUniformLocation(shader.Program, (name + number).c_str()), i);
-			// And finally bind the texture
-			glBindTexture(GL_TEXTURE_2D, this->textures[i].id);
+			TextureBinding binding;
+			binding.unit = (GLuint)this->bindings.size();
+			binding.texture = this->textures[i].id;
+			binding.location = shader.GetUniformLocation(name + number);
+			if (binding.location >= 0)
+			{
+				this->bindings.push_back(binding);
+			}
 		}
+		this->shininessLocation = shader.GetUniformLocation("material.shininess");
+		this->bakedProgram = shader.Program;
+	}
 
-		// Also set each mesh's shininess property to a default value (if you want you could extend this to another mesh property and possibly change this value)
-		glUniform1f(glGetUniformLocation(shader.Program, "material.shininess"), 16.0f);
+	// Render the mesh. No reserva memoria ni deshace los enlaces al terminar: quien dibuje
+	// después enlaza lo que necesite.
+	void Draw(const Shader& shader)
+	{
+		this->BindMaterial(shader);
 
-		// Draw mesh
-		glBindVertexArray(this->VAO);
-		glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
+		// Draw mesh: su rango dentro del búfer compartido
+		SharedGeometry().Bind();
+		glDrawElementsBaseVertex(GL_TRIANGLES, this->range.indexCount, GL_UNSIGNED_INT,
+			(GLvoid *)(this->range.firstIndex * sizeof(GLuint)), this->range.baseVertex);
+	}
 
-		// Always good practice to set everything back to defaults once configured.
-		for (GLuint i = 0; i < this->textures.size(); i++)
+	// Enlaza las texturas y asigna los uniforms de material resueltos por Bake
+	void BindMaterial(const Shader& shader)
+	{
+		if (this->bakedProgram != shader.Program)
+		{
+			this->Bake(shader); // Solo la primera vez con un programa distinto
+		}
+		for (const TextureBinding& binding : this->bindings)
 		{
-			glActiveTexture(GL_TEXTURE0 + i);
-			glBindTexture(GL_TEXTURE_2D, 0);
+			GLState().BindTexture(binding.unit, GL_TEXTURE_2D, binding.texture);
+			glUniform1i(binding.location, binding.unit);
+		}
+
+		// Also set each mesh's shininess property to a default value (if you want you could extend this to another mesh property and possibly change this value)
+		if (this->shininessLocation >= 0)
+		{
+			glUniform1f(this->shininessLocation, 16.0f);
 		}
 	}
 
+	// true si dibujar other después de esta malla no requiere volver a enlazar el material
+	bool SameMaterial(const Mesh& other) const
+	{
+		if (this->bakedProgram != other.bakedProgram || this->bindings.size() != other.bindings.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < this->bindings.size(); i++)
+		{
+			if (this->bindings[i].texture != other.bindings[i].texture || this->bindings[i].location != other.bindings[i].location)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Posición de la malla en SharedGeometry()
+	const MeshRange& Range() const
+	{
+		return this->range;
+	}
+
 private:
+	// Textura de una unidad y la localidad del sampler que la lee
+	struct TextureBinding
+	{
+		GLuint unit;
+		GLuint texture;
+		GLint location;
+	};
+
 	/*  Render data  */
-	GLuint VAO, VBO, EBO;
+	MeshRange range;
+	vector<TextureBinding> bindings;
+	GLint shininessLocation = -1;
+	GLuint bakedProgram = 0;		// Programa para el que se resolvieron bindings (0 = ninguno)
 
 	/*  Functions    */
-	// Initializes all the buffer objects/arrays
+	// Agrega los vértices e índices al búfer compartido; se suben a la GPU al enlazarlo
 	void setupMesh()
 	{
-		// Create buffers/arrays
-		glGenVertexArrays(1, &this->VAO);
-		glGenBuffers(1, &this->VBO);
-		glGenBuffers(1, &this->EBO);
-
-		glBindVertexArray(this->VAO);
-		// Load data into vertex buffers
-		glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-		// A great thing about structs is that their memory layout is sequential for all its items.
-		// The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-		// again translates to 3/2 floats which translates to a byte array.
-		glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(Vertex), &this->vertices[0], GL_STATIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(GLuint), &this->indices[0], GL_STATIC_DRAW);
-
-		// Set the vertex attribute pointers
-		// Vertex Positions
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)0);
-		// Vertex Normals
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, Normal));
-		// Vertex Texture Coords
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, TexCoords));
-
-		glBindVertexArray(0);
+		this->range = SharedGeometry().AddMesh(this->vertices, this->indices);
 	}
 };
\ No newline at end of file
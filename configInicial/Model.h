@@ -32,8 +32,17 @@ public:
 		this->loadModel(path);
 	}
 
+	// Resuelve los materiales de todas las mallas para shader (ver Mesh::Bake)
+	void Bake(const Shader& shader)
+	{
+		for (GLuint i = 0; i < this->meshes.size(); i++)
+		{
+			this->meshes[i].Bake(shader);
+		}
+	}
+
 	// Draws the model, and thus all its meshes
-	void Draw(Shader shader)
+	void Draw(const Shader& shader)
 	{
 		for (GLuint i = 0; i < this->meshes.size(); i++)
 		{
@@ -41,6 +50,18 @@ public:
 		}
 	}
 
+	// Carpeta del archivo del modelo, de donde se cargan sus texturas
+	const string& Directory() const
+	{
+		return this->directory;
+	}
+
+	// Mallas del modelo, para armar tablas de comandos de dibujo sobre SharedGeometry()
+	vector<Mesh>& Meshes()
+	{
+		return this->meshes;
+	}
+
 private:
 	/*  Model Data  */
 	vector<Mesh> meshes;
@@ -220,7 +241,7 @@ GLint TextureFromFile(const char *path, string directory)
 	unsigned char *image = SOIL_load_image(filename.c_str(), &width, &height, 0, SOIL_LOAD_RGB);
 
 	// Assign texture to ID
-	glBindTexture(GL_TEXTURE_2D, textureID);
+	GLState().BindTexture(0, GL_TEXTURE_2D, textureID);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
 	glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -229,7 +250,7 @@ GLint TextureFromFile(const char *path, string directory)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState().BindTexture(0, GL_TEXTURE_2D, 0);
 	SOIL_free_image_data(image);
 
 	return textureID;
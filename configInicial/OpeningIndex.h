@@ -0,0 +1,477 @@
+#pragma once
+
+// Índice de posiciones para el explorador de aperturas.
+// El archivo es una tabla ordenada por (clave Zobrist, movimiento) con cuántas partidas
+// ganaron las blancas, quedaron tablas o ganaron las negras después de ese movimiento.
+// Como está ordenada, una consulta es una búsqueda binaria sobre el archivo proyectado
+// en memoria, sin cargarlo.
+//
+// La construcción reparte las partidas entre los hilos; cada hilo acumula entradas en su
+// propio bloque, y cuando el bloque se llena lo ordena y lo guarda como un archivo
+// temporal ordenado. Al final los bloques se mezclan (merge de k vías) en el índice, así
+// que el corpus puede ser más grande que la memoria. Si hay más de
+// OPENING_INDEX_MERGE_FAN_IN bloques se mezclan primero por grupos en pasadas intermedias,
+// para no abrir un archivo por bloque.
+//
+// Uso: configInicial.exe --book-build partidas.(pgn|bin) aperturas.idx [hilos]
+//      configInicial.exe --book-probe aperturas.idx "FEN"
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <queue>
+#include <mutex>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+#include "ChessRules.h"
+#include "Pgn.h"
+#include "GameArchive.h"
+#include "ThreadPool.h"
+#include "MappedFile.h"
+
+const char OPENING_INDEX_MAGIC[4] = { 'A', 'J', 'D', 'X' };
+const uint32_t OPENING_INDEX_VERSION = 2;			// 2: las claves incluyen enroque y captura al paso
+const int OPENING_INDEX_MAX_PLY = 40;				// Solo se indexan las primeras jugadas de cada partida
+const size_t OPENING_INDEX_RUN_ENTRIES = 1 << 20;	// Entradas por bloque antes de ordenarlo y guardarlo
+const size_t OPENING_INDEX_MERGE_FAN_IN = 64;		// Bloques abiertos a la vez en cada mezcla
+
+struct OpeningIndexHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t entryCount;
+};
+
+struct OpeningIndexEntry
+{
+	uint64_t key;
+	uint16_t move;		// Origen (6 bits) | destino (6 bits) << 6 | coronación (3 bits) << 12
+	uint16_t reserved;
+	uint32_t whiteWins;
+	uint32_t draws;
+	uint32_t blackWins;
+
+	bool operator<(const OpeningIndexEntry& other) const
+	{
+		return this->key != other.key ? this->key < other.key : this->move < other.move;
+	}
+};
+
+class OpeningIndex
+{
+public:
+	bool Open(const std::string& path)
+	{
+		if (!this->file.Open(path) || this->file.Size() < sizeof(OpeningIndexHeader))
+		{
+			return false;
+		}
+		OpeningIndexHeader header;
+		std::memcpy(&header, this->file.Data(), sizeof(header));
+		if (std::memcmp(header.magic, OPENING_INDEX_MAGIC, sizeof(OPENING_INDEX_MAGIC)) != 0 || header.version != OPENING_INDEX_VERSION ||
+			sizeof(header) + header.entryCount * sizeof(OpeningIndexEntry) > this->file.Size())
+		{
+			this->file.Close();
+			return false;
+		}
+		this->entries = (const OpeningIndexEntry*)(this->file.Data() + sizeof(header));
+		this->entryCount = (size_t)header.entryCount;
+		return true;
+	}
+
+	bool IsOpen() const
+	{
+		return this->entries != nullptr && this->file.Data() != nullptr;
+	}
+
+	// Estadísticas de todos los movimientos jugados desde la posición con esta clave
+	void Probe(uint64_t key, std::vector<OpeningIndexEntry>& results) const
+	{
+		results.clear();
+		if (!this->IsOpen())
+		{
+			return;
+		}
+		OpeningIndexEntry probe = {};
+		probe.key = key;
+		const OpeningIndexEntry* found = std::lower_bound(this->entries, this->entries + this->entryCount, probe);
+		for (; found != this->entries + this->entryCount && found->key == key; ++found)
+		{
+			results.push_back(*found);
+		}
+	}
+
+private:
+	MappedFile file;
+	const OpeningIndexEntry* entries = nullptr;
+	size_t entryCount = 0;
+};
+
+// Ordena un bloque y junta las entradas repetidas sumando sus contadores
+inline void SortAndMergeEntries(std::vector<OpeningIndexEntry>& entries)
+{
+	std::sort(entries.begin(), entries.end());
+	size_t out = 0;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (out > 0 && entries[out - 1].key == entries[i].key && entries[out - 1].move == entries[i].move)
+		{
+			entries[out - 1].whiteWins += entries[i].whiteWins;
+			entries[out - 1].draws += entries[i].draws;
+			entries[out - 1].blackWins += entries[i].blackWins;
+		}
+		else
+		{
+			entries[out++] = entries[i];
+		}
+	}
+	entries.resize(out);
+}
+
+class OpeningIndexBuilder
+{
+public:
+	OpeningIndexBuilder(const std::string& outputPath, int numThreads) : outputPath(outputPath), buffers(numThreads) {}
+
+	// Agrega las primeras jugadas de una partida. Solo la llama el hilo threadId.
+	void AddGame(int threadId, const Position& start, const std::vector<ChessMove>& moves, const std::string& result)
+	{
+		uint32_t white = (result == "1-0") ? 1 : 0;
+		uint32_t draw = (result == "1/2-1/2") ? 1 : 0;
+		uint32_t black = (result == "0-1") ? 1 : 0;
+		if (white + draw + black == 0)
+		{
+			return; // Partida sin resultado conocido
+		}
+
+		std::vector<OpeningIndexEntry>& buffer = this->buffers[threadId];
+		Position pos = start;
+		MoveUndo undo;
+		for (size_t ply = 0; ply < moves.size() && ply < (size_t)OPENING_INDEX_MAX_PLY; ply++)
+		{
+			OpeningIndexEntry entry = {};
+			entry.key = PositionKey(pos);
+			entry.move = PackMove(moves[ply]);
+			entry.whiteWins = white;
+			entry.draws = draw;
+			entry.blackWins = black;
+			buffer.push_back(entry);
+			MakeMove(pos, moves[ply], undo);
+		}
+		if (buffer.size() >= OPENING_INDEX_RUN_ENTRIES)
+		{
+			this->writeRun(buffer);
+		}
+	}
+
+	// Guarda los bloques pendientes y los mezcla en el índice final. Si algo falla escribe el
+	// error (ERROR::APERTURAS::...) y devuelve false; los archivos temporales se borran siempre.
+	bool Finish(uint64_t& entryCount)
+	{
+		for (std::vector<OpeningIndexEntry>& buffer : this->buffers)
+		{
+			if (!buffer.empty())
+			{
+				this->writeRun(buffer);
+			}
+		}
+		bool ok = !this->failed;
+
+		// Mezclas intermedias de a lo más OPENING_INDEX_MERGE_FAN_IN bloques hasta que quepan
+		// todos en la mezcla final: nunca hay más archivos abiertos que eso
+		uint64_t unused;
+		while (ok && this->runPaths.size() > OPENING_INDEX_MERGE_FAN_IN)
+		{
+			std::vector<std::string> merged;
+			for (size_t first = 0; ok && first < this->runPaths.size(); first += OPENING_INDEX_MERGE_FAN_IN)
+			{
+				size_t last = std::min(first + OPENING_INDEX_MERGE_FAN_IN, this->runPaths.size());
+				std::vector<std::string> group(this->runPaths.begin() + first, this->runPaths.begin() + last);
+				std::string path = this->nextRunPath();
+				merged.push_back(path);
+				ok = this->mergeRuns(group, path, false, unused);
+			}
+			this->removeRuns();
+			this->runPaths.swap(merged);
+		}
+		ok = ok && this->mergeRuns(this->runPaths, this->outputPath, true, entryCount);
+		this->removeRuns();
+		return ok;
+	}
+
+	size_t RunCount() const
+	{
+		return this->runCount;
+	}
+
+private:
+	std::string outputPath;
+	std::vector<std::vector<OpeningIndexEntry>> buffers;
+	std::vector<std::string> runPaths;
+	size_t runCount = 0;			// Bloques escritos por los hilos (sin contar las mezclas intermedias)
+	size_t nextRun = 0;
+	bool failed = false;
+	std::mutex runMutex;
+
+	std::string nextRunPath()
+	{
+		return this->outputPath + ".run" + std::to_string(this->nextRun++);
+	}
+
+	void removeRuns()
+	{
+		for (const std::string& run : this->runPaths)
+		{
+			std::remove(run.c_str());
+		}
+		this->runPaths.clear();
+	}
+
+	void writeRun(std::vector<OpeningIndexEntry>& buffer)
+	{
+		std::string path;
+		{
+			std::lock_guard<std::mutex> lock(this->runMutex);
+			if (this->failed)
+			{
+				buffer.clear(); // Ya falló un bloque: el índice no se va a escribir
+				return;
+			}
+			path = this->nextRunPath();
+			this->runPaths.push_back(path);
+			this->runCount++;
+		}
+		SortAndMergeEntries(buffer);
+		std::ofstream run(path, std::ios::binary | std::ios::trunc);
+		run.write((const char*)buffer.data(), buffer.size() * sizeof(OpeningIndexEntry));
+		run.close();
+		buffer.clear();
+		if (run.fail())
+		{
+			std::lock_guard<std::mutex> lock(this->runMutex);
+			std::cerr << "ERROR::APERTURAS::NO_SE_PUDO_ESCRIBIR_BLOQUE " << path << std::endl;
+			this->failed = true;
+		}
+	}
+
+	// Lee la siguiente entrada de un bloque. Al final del bloque devuelve false sin error; un
+	// bloque cortado a media entrada o un error de lectura ponen error en true.
+	static bool readEntry(std::ifstream& run, OpeningIndexEntry& entry, bool& error)
+	{
+		if (run.read((char*)&entry, sizeof(entry)))
+		{
+			return true;
+		}
+		error = error || run.bad() || run.gcount() != 0;
+		return false;
+	}
+
+	// Mezcla los bloques ordenados inputs en output juntando las entradas repetidas. Con
+	// withHeader el resultado es el índice final; si no, es otro bloque.
+	bool mergeRuns(const std::vector<std::string>& inputs, const std::string& output, bool withHeader, uint64_t& entryCount)
+	{
+		std::vector<std::ifstream> runs;
+		runs.reserve(inputs.size());
+		for (const std::string& path : inputs)
+		{
+			runs.emplace_back(path, std::ios::binary);
+			if (!runs.back())
+			{
+				std::cerr << "ERROR::APERTURAS::NO_SE_PUDO_ABRIR_BLOQUE " << path << std::endl;
+				return false;
+			}
+		}
+		std::ofstream out(output, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			std::cerr << "ERROR::APERTURAS::NO_SE_PUDO_CREAR " << output << std::endl;
+			return false;
+		}
+		OpeningIndexHeader header = {};
+		if (withHeader)
+		{
+			out.write((const char*)&header, sizeof(header)); // Se reescribe al final
+		}
+
+		// Cola con la entrada más pequeña de cada bloque
+		typedef std::pair<OpeningIndexEntry, size_t> HeapItem;
+		auto greater = [](const HeapItem& a, const HeapItem& b) { return b.first < a.first; };
+		std::priority_queue<HeapItem, std::vector<HeapItem>, decltype(greater)> heap(greater);
+		bool readError = false;
+		for (size_t i = 0; i < runs.size(); i++)
+		{
+			OpeningIndexEntry entry;
+			if (readEntry(runs[i], entry, readError))
+			{
+				heap.push(HeapItem(entry, i));
+			}
+		}
+
+		entryCount = 0;
+		bool hasPending = false;
+		OpeningIndexEntry pending = {};
+		while (!heap.empty() && !readError)
+		{
+			HeapItem item = heap.top();
+			heap.pop();
+			if (hasPending && pending.key == item.first.key && pending.move == item.first.move)
+			{
+				pending.whiteWins += item.first.whiteWins;
+				pending.draws += item.first.draws;
+				pending.blackWins += item.first.blackWins;
+			}
+			else
+			{
+				if (hasPending)
+				{
+					out.write((const char*)&pending, sizeof(pending));
+					entryCount++;
+				}
+				pending = item.first;
+				hasPending = true;
+			}
+
+			OpeningIndexEntry next;
+			if (readEntry(runs[item.second], next, readError))
+			{
+				heap.push(HeapItem(next, item.second));
+			}
+		}
+		if (readError)
+		{
+			std::cerr << "ERROR::APERTURAS::NO_SE_PUDO_LEER_BLOQUE " << output << std::endl;
+			return false;
+		}
+		if (hasPending)
+		{
+			out.write((const char*)&pending, sizeof(pending));
+			entryCount++;
+		}
+
+		if (withHeader)
+		{
+			std::memcpy(header.magic, OPENING_INDEX_MAGIC, sizeof(header.magic));
+			header.version = OPENING_INDEX_VERSION;
+			header.entryCount = entryCount;
+			out.seekp(0);
+			out.write((const char*)&header, sizeof(header));
+		}
+		out.close();
+		if (out.fail())
+		{
+			std::cerr << "ERROR::APERTURAS::NO_SE_PUDO_ESCRIBIR " << output << std::endl;
+			return false;
+		}
+		return true;
+	}
+};
+
+// Construye el índice a partir de un archivo binario de GameArchive o de un PGN
+inline int BuildOpeningIndex(const std::string& inputPath, const std::string& outputPath, int numThreads)
+{
+	ThreadPool pool(numThreads);
+	OpeningIndexBuilder builder(outputPath, pool.Size());
+	const size_t BATCH_SIZE = 1024;
+	long long games = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	GameArchive archive;
+	if (archive.Open(inputPath))
+	{
+		for (uint32_t first = 0; first < archive.GameCount(); first += (uint32_t)BATCH_SIZE)
+		{
+			size_t count = std::min((size_t)(archive.GameCount() - first), BATCH_SIZE);
+			pool.ParallelFor(count, [&](size_t i, int threadId) {
+				ArchivedGame game;
+				if (archive.ReadGame(first + (uint32_t)i, game))
+				{
+					std::string result;
+					for (const auto& tag : game.tags)
+					{
+						if (tag.first == "Result")
+						{
+							result = tag.second;
+						}
+					}
+					builder.AddGame(threadId, game.start, game.moves, result);
+				}
+			});
+			games += (long long)count;
+		}
+	}
+	else
+	{
+		PgnReader reader;
+		if (!reader.Open(inputPath))
+		{
+			std::cerr << "ERROR::APERTURAS::NO_SE_PUDO_ABRIR " << inputPath << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::vector<PgnGame> batch(BATCH_SIZE);
+		bool moreGames = true;
+		while (moreGames)
+		{
+			size_t count = 0;
+			while (count < BATCH_SIZE && (moreGames = reader.Next(batch[count])))
+			{
+				count++;
+			}
+			pool.ParallelFor(count, [&](size_t i, int threadId) {
+				PgnReplay replay = ReplayPgnGame(batch[i]);
+				if (replay.legal)
+				{
+					builder.AddGame(threadId, replay.start, replay.moves, batch[i].GetTag("Result"));
+				}
+			});
+			games += (long long)count;
+		}
+	}
+
+	uint64_t entries = 0;
+	if (!builder.Finish(entries))
+	{
+		return EXIT_FAILURE; // Finish ya informó el error
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cerr << "Partidas: " << games << "  entradas: " << entries << "  bloques: " << builder.RunCount() << std::endl;
+	std::cerr << "Tiempo: " << std::fixed << std::setprecision(3) << seconds << " s  ("
+		<< std::setprecision(0) << (seconds > 0.0 ? games / seconds : 0.0) << " partidas/s)" << std::endl;
+	return EXIT_SUCCESS;
+}
+
+inline int ProbeOpeningIndex(const std::string& indexPath, const std::string& fen, std::ostream& out)
+{
+	OpeningIndex index;
+	Position pos;
+	if (!index.Open(indexPath))
+	{
+		std::cerr << "ERROR::APERTURAS::NO_SE_PUDO_ABRIR " << indexPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (!LoadFEN(pos, fen))
+	{
+		std::cerr << "ERROR::APERTURAS::FEN_INVALIDO " << fen << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<OpeningIndexEntry> results;
+	auto start = std::chrono::steady_clock::now();
+	index.Probe(PositionKey(pos), results);
+	double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	for (const OpeningIndexEntry& entry : results)
+	{
+		ChessMove move = UnpackMove(entry.move);
+		out << (char)('a' + move.fromCol) << (move.fromRow + 1) << (char)('a' + move.toCol) << (move.toRow + 1)
+			<< "\t+" << entry.whiteWins << " =" << entry.draws << " -" << entry.blackWins << std::endl;
+	}
+	std::cerr << results.size() << " movimientos en " << std::fixed << std::setprecision(1) << micros << " us" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,304 @@
+#pragma once
+
+// Perft: cuenta los nodos del árbol de movimientos hasta cierta profundidad.
+// Sirve para probar GenerateMoves/MakeMove a gran escala y como prueba de rendimiento
+// en varios núcleos.
+//
+// Los movimientos de la raíz se reparten entre los hilos; cada hilo toma trabajo de su
+// propia cola y, cuando se le acaba, roba de la cola de otro. Los subárboles ya contados
+// se guardan en una tabla compartida indexada por (clave Zobrist, profundidad), así que
+// las transposiciones se cuentan una sola vez.
+//
+// Uso: configInicial.exe --perft profundidad ["FEN"] [hilos] [MB de tabla]
+
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <cstdlib>
+
+#include "ChessRules.h"
+#include "LargePages.h"
+
+// Tabla compartida sin candados. Cada entrada guarda la clave mezclada (XOR) con el dato,
+// de modo que si dos hilos escriben la misma entrada a la vez la lectura no coincide con
+// la clave y se descarta en lugar de devolver un conteo equivocado.
+class PerftHash
+{
+public:
+	// La tabla se limpia con initThreads hilos (ver ClearMemory)
+	PerftHash(size_t megabytes, int initThreads)
+	{
+		size_t count = AllocateTable(this->memory, megabytes, sizeof(Entry), "PERFT");
+		this->entries = (count > 0) ? (Entry*)this->memory.Data() : &this->fallback;
+		this->mask = (count > 0) ? count - 1 : 0;
+		ClearMemory(this->entries, this->SizeInBytes(), initThreads);
+	}
+
+	bool Probe(uint64_t key, int depth, uint64_t& nodes) const
+	{
+		const Entry& entry = this->entries[key & this->mask];
+		uint64_t data = entry.data.load(std::memory_order_relaxed);
+		uint64_t check = entry.check.load(std::memory_order_relaxed);
+		if ((check ^ data) != key || (int)(data & 0xFF) != depth)
+		{
+			return false;
+		}
+		nodes = data >> 8;
+		return true;
+	}
+
+	void Store(uint64_t key, int depth, uint64_t nodes)
+	{
+		Entry& entry = this->entries[key & this->mask];
+		uint64_t data = (nodes << 8) | (uint64_t)depth;
+		entry.check.store(key ^ data, std::memory_order_relaxed);
+		entry.data.store(data, std::memory_order_relaxed);
+	}
+
+	size_t SizeInBytes() const
+	{
+		return (this->mask + 1) * sizeof(Entry);
+	}
+
+	const LargePageMemory& Memory() const
+	{
+		return this->memory;
+	}
+
+private:
+	struct Entry
+	{
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> data;	// Nodos << 8 | profundidad
+	};
+
+	LargePageMemory memory;
+	Entry* entries = nullptr;
+	size_t mask = 0;
+	// Única entrada que se usa si no se pudo reservar la tabla
+	Entry fallback;
+};
+
+// Estadísticas de un hilo
+struct PerftThreadStats
+{
+	uint64_t nodes = 0;			// Hojas contadas por este hilo
+	int rootMoves = 0;			// Movimientos de la raíz que resolvió
+	int steals = 0;				// Movimientos que tomó de la cola de otro hilo
+	uint64_t hashProbes = 0;
+	uint64_t hashHits = 0;
+	double seconds = 0.0;
+};
+
+class PerftWorker
+{
+public:
+	PerftWorker(PerftHash* hash, PerftThreadStats& stats) : hash(hash), stats(stats) {}
+
+	uint64_t Count(Position& pos, int depth)
+	{
+		if ((int)this->moveLists.size() < depth + 1)
+		{
+			this->moveLists.resize(depth + 1);
+		}
+		return this->count(pos, depth);
+	}
+
+private:
+	PerftHash* hash;
+	PerftThreadStats& stats;
+	std::vector<std::vector<ChessMove>> moveLists;	// Una lista reutilizable por profundidad
+
+	uint64_t count(Position& pos, int depth)
+	{
+		if (depth == 0)
+		{
+			return 1;
+		}
+		std::vector<ChessMove>& moves = this->moveLists[depth];
+		GenerateMoves(pos, moves);
+		if (depth == 1)
+		{
+			return moves.size(); // No hace falta hacer cada movimiento para contarlo
+		}
+
+		uint64_t key = 0;
+		if (this->hash != nullptr)
+		{
+			key = PositionKey(pos);
+			uint64_t cached;
+			this->stats.hashProbes++;
+			if (this->hash->Probe(key, depth, cached))
+			{
+				this->stats.hashHits++;
+				return cached;
+			}
+		}
+
+		uint64_t nodes = 0;
+		MoveUndo undo;
+		for (size_t i = 0; i < moves.size(); i++)
+		{
+			ChessMove move = moves[i];
+			MakeMove(pos, move, undo);
+			nodes += this->count(pos, depth - 1);
+			UnmakeMove(pos, move, undo);
+		}
+
+		if (this->hash != nullptr)
+		{
+			this->hash->Store(key, depth, nodes);
+		}
+		return nodes;
+	}
+};
+
+// Cola de movimientos de la raíz de un hilo. El dueño toma del frente y los demás roban del final.
+struct PerftQueue
+{
+	std::mutex mutex;
+	std::deque<size_t> moves;
+
+	bool PopFront(size_t& move)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (this->moves.empty())
+		{
+			return false;
+		}
+		move = this->moves.front();
+		this->moves.pop_front();
+		return true;
+	}
+
+	bool StealBack(size_t& move)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (this->moves.empty())
+		{
+			return false;
+		}
+		move = this->moves.back();
+		this->moves.pop_back();
+		return true;
+	}
+};
+
+inline int RunPerft(const std::string& fen, int depth, int numThreads, size_t hashMegabytes, std::ostream& out)
+{
+	Position root;
+	if (!LoadFEN(root, fen))
+	{
+		std::cerr << "ERROR::PERFT::FEN_INVALIDO " << fen << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (depth < 1)
+	{
+		std::cerr << "ERROR::PERFT::PROFUNDIDAD_INVALIDA " << depth << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (numThreads <= 0)
+	{
+		numThreads = (int)std::thread::hardware_concurrency();
+		if (numThreads <= 0)
+		{
+			numThreads = 1;
+		}
+	}
+
+	std::unique_ptr<PerftHash> hash;
+	if (hashMegabytes > 0)
+	{
+		hash.reset(new PerftHash(hashMegabytes, numThreads));
+	}
+
+	std::vector<ChessMove> rootMoves;
+	GenerateMoves(root, rootMoves);
+	std::vector<uint64_t> rootCounts(rootMoves.size(), 0);
+
+	// Reparto inicial en orden circular
+	std::vector<PerftQueue> queues(numThreads);
+	for (size_t i = 0; i < rootMoves.size(); i++)
+	{
+		queues[i % numThreads].moves.push_back(i);
+	}
+
+	std::vector<PerftThreadStats> stats(numThreads);
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&, t]() {
+			auto threadStart = std::chrono::steady_clock::now();
+			PerftWorker worker(hash.get(), stats[t]);
+			Position pos = root;
+			MoveUndo undo;
+			for (;;)
+			{
+				size_t index;
+				bool found = queues[t].PopFront(index);
+				for (int other = 1; !found && other < numThreads; other++)
+				{
+					found = queues[(t + other) % numThreads].StealBack(index);
+					if (found)
+					{
+						stats[t].steals++;
+					}
+				}
+				if (!found)
+				{
+					break;
+				}
+
+				MakeMove(pos, rootMoves[index], undo);
+				rootCounts[index] = worker.Count(pos, depth - 1);
+				UnmakeMove(pos, rootMoves[index], undo);
+				stats[t].nodes += rootCounts[index];
+				stats[t].rootMoves++;
+			}
+			stats[t].seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - threadStart).count();
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	uint64_t total = 0;
+	for (size_t i = 0; i < rootMoves.size(); i++)
+	{
+		out << MoveToString(rootMoves[i]) << ": " << rootCounts[i] << std::endl;
+		total += rootCounts[i];
+	}
+	out << "Nodos: " << total << std::endl;
+
+	std::cerr << std::fixed << std::setprecision(3);
+	for (int t = 0; t < numThreads; t++)
+	{
+		const PerftThreadStats& s = stats[t];
+		std::cerr << "Hilo " << t << ": raiz " << s.rootMoves << "  robados " << s.steals << "  nodos " << s.nodes
+			<< "  tabla " << s.hashHits << "/" << s.hashProbes << "  " << s.seconds << " s" << std::endl;
+	}
+	std::cerr << "Tiempo: " << seconds << " s  (" << std::setprecision(0) << (seconds > 0.0 ? total / seconds : 0.0)
+		<< " nodos/s, " << numThreads << " hilos";
+	if (hash)
+	{
+		std::cerr << ", tabla " << (hash->SizeInBytes() >> 20) << " MB en paginas " << LargePageKindName(hash->Memory().Kind());
+		long long hugeBytes = hash->Memory().ResidentHugeBytes();
+		if (hugeBytes >= 0)
+		{
+			std::cerr << " (" << (hugeBytes >> 20) << " MB en paginas grandes)";
+		}
+	}
+	std::cerr << ")" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,467 @@
+#pragma once
+
+// Lectura de partidas en formato PGN y validación de sus jugadas contra ChessRules.h.
+// PgnReader lee el archivo partida por partida, así que nunca hay más de un lote de
+// partidas en memoria sin importar el tamaño del archivo. Las jugadas se resuelven contra la
+// lista de jugadas legales (GenerateMoves), con enroque y captura al paso.
+//
+// Uso: configInicial.exe --pgn partidas.pgn [hilos]
+
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <utility>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+#include "ChessRules.h"
+#include "ThreadPool.h"
+#include "MappedFile.h"
+
+// Una partida tal como viene en el archivo: etiquetas y texto de jugadas sin interpretar
+struct PgnGame
+{
+	std::vector<std::pair<std::string, std::string>> tags;
+	std::string movetext;
+
+	std::string GetTag(const std::string& name) const
+	{
+		for (const auto& tag : this->tags)
+		{
+			if (tag.first == name)
+			{
+				return tag.second;
+			}
+		}
+		return "";
+	}
+};
+
+// Resultado de reproducir una partida jugada por jugada
+struct PgnReplay
+{
+	bool legal = false;
+	Position start;					// Posición inicial (la normal o la etiqueta FEN)
+	std::vector<ChessMove> moves;	// Jugadas aceptadas, en orden
+	std::string badMove;			// Primera jugada rechazada
+	std::string error;
+};
+
+// Lee partidas de un archivo PGN una por una. El archivo se proyecta en memoria (MappedFile):
+// las líneas se recorren directamente sobre las páginas del archivo sin copiarlo a un flujo.
+class PgnReader
+{
+public:
+	bool Open(const std::string& path)
+	{
+		this->position = 0;
+		return this->file.Open(path);
+	}
+
+	// Devuelve false cuando ya no quedan partidas. Una partida termina en su resultado
+	// (1-0, 0-1, 1/2-1/2 o *) o, si falta, en la etiqueta de la siguiente.
+	bool Next(PgnGame& game)
+	{
+		game.tags.clear();
+		game.movetext.clear();
+		bool hasContent = false;
+		bool inComment = false;
+		const char* data = (const char*)this->file.Data();
+		size_t size = this->file.Size();
+
+		while (this->position < size)
+		{
+			const char* line = data + this->position;
+			const char* newline = (const char*)std::memchr(line, '\n', size - this->position);
+			size_t length = (newline != nullptr) ? (size_t)(newline - line) : size - this->position;
+			size_t next = this->position + length + 1;
+			if (length > 0 && line[length - 1] == '\r')
+			{
+				length--;
+			}
+
+			if (length > 0 && line[0] == '[' && !inComment)
+			{
+				// Una etiqueta después de jugadas marca el inicio de la siguiente partida
+				if (!game.movetext.empty())
+				{
+					return true;
+				}
+				parseTag(std::string(line, length), game);
+				hasContent = true;
+				this->position = next;
+				continue;
+			}
+
+			size_t used = length;
+			bool finished = findResult(line, length, inComment, used);
+			if (hasText(line, used))
+			{
+				game.movetext.append(line, used);
+				game.movetext += '\n';
+				hasContent = true;
+			}
+			if (finished)
+			{
+				// Lo que siga en la línea es de la siguiente partida
+				this->position += used;
+				return true;
+			}
+			this->position = next;
+		}
+		return hasContent;
+	}
+
+private:
+	MappedFile file;
+	size_t position = 0;	// Byte donde empieza lo que falta leer
+
+	// [Nombre "Valor"]
+	static void parseTag(const std::string& line, PgnGame& game)
+	{
+		size_t nameEnd = line.find(' ');
+		size_t valueStart = line.find('"');
+		size_t valueEnd = line.rfind('"');
+		if (nameEnd == std::string::npos || valueStart == std::string::npos || valueEnd <= valueStart)
+		{
+			return;
+		}
+		game.tags.emplace_back(line.substr(1, nameEnd - 1), line.substr(valueStart + 1, valueEnd - valueStart - 1));
+	}
+
+	static bool hasText(const char* text, size_t length)
+	{
+		for (size_t i = 0; i < length; i++)
+		{
+			if (text[i] != ' ' && text[i] != '\t')
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Busca el resultado fuera de comentarios { } (que pueden seguir en otras líneas) y de
+	// comentarios de fin de línea. Si lo encuentra, end queda justo después de él.
+	static bool findResult(const char* line, size_t length, bool& inComment, size_t& end)
+	{
+		size_t tokenStart = 0;
+		for (size_t i = 0; i <= length; i++)
+		{
+			char ch = (i < length) ? line[i] : ' ';
+			if (inComment)
+			{
+				if (ch == '}')
+				{
+					inComment = false;
+					tokenStart = i + 1;
+				}
+				continue;
+			}
+			bool separator = ch == ' ' || ch == '\t' || ch == '{' || ch == ';' || ch == '(' || ch == ')';
+			if (!separator)
+			{
+				continue;
+			}
+			if (isResult(line + tokenStart, i - tokenStart))
+			{
+				end = i;
+				return true;
+			}
+			if (ch == ';')
+			{
+				return false;
+			}
+			inComment = (ch == '{');
+			tokenStart = i + 1;
+		}
+		return false;
+	}
+
+	static bool isResult(const char* token, size_t length)
+	{
+		std::string text(token, length);
+		return text == "1-0" || text == "0-1" || text == "1/2-1/2" || text == "*";
+	}
+};
+
+// Separa el texto de jugadas en jugadas SAN, quitando comentarios, variantes,
+// NAGs ($n), números de jugada y el resultado final.
+inline void TokenizeMovetext(const std::string& movetext, std::vector<std::string>& sanMoves)
+{
+	sanMoves.clear();
+	std::string token;
+	int variationDepth = 0;
+
+	auto flush = [&]() {
+		// Quita el número de jugada pegado ("12.e4", "12...Nf6")
+		size_t i = 0;
+		while (i < token.size() && token[i] >= '0' && token[i] <= '9')
+		{
+			i++;
+		}
+		if (i < token.size() && token[i] == '.')
+		{
+			while (i < token.size() && token[i] == '.')
+			{
+				i++;
+			}
+			token.erase(0, i);
+		}
+		bool isResult = token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+		bool isAnnotation = token == "e.p." || (!token.empty() && token[0] == '$');
+		if (!token.empty() && !isResult && !isAnnotation && variationDepth == 0)
+		{
+			sanMoves.push_back(token);
+		}
+		token.clear();
+	};
+
+	for (size_t i = 0; i < movetext.size(); i++)
+	{
+		char ch = movetext[i];
+		if (ch == '{')
+		{
+			flush();
+			size_t end = movetext.find('}', i);
+			i = (end == std::string::npos) ? movetext.size() : end;
+		}
+		else if (ch == ';')
+		{
+			flush();
+			size_t end = movetext.find('\n', i);
+			i = (end == std::string::npos) ? movetext.size() : end;
+		}
+		else if (ch == '(')
+		{
+			flush();
+			variationDepth++;
+		}
+		else if (ch == ')')
+		{
+			flush();
+			if (variationDepth > 0)
+			{
+				variationDepth--;
+			}
+		}
+		else if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r')
+		{
+			flush();
+		}
+		else
+		{
+			token += ch;
+		}
+	}
+	flush();
+}
+
+inline PieceType PieceFromLetter(char letter)
+{
+	switch (letter)
+	{
+	case 'K': return KING;
+	case 'Q': return QUEEN;
+	case 'R': return ROOK;
+	case 'B': return BISHOP;
+	case 'N': return KNIGHT;
+	default: return EMPTY;
+	}
+}
+
+// Busca, entre las jugadas legales de la posición (moves, de GenerateMoves), la que corresponde
+// a una jugada SAN. Devuelve false y llena error si la jugada no existe o es ambigua.
+inline bool ResolveSan(const Position& pos, const std::vector<ChessMove>& moves, std::string san, ChessMove& result, std::string& error)
+{
+	while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?'))
+	{
+		san.pop_back();
+	}
+	if (san.compare(0, 3, "O-O") == 0 || san.compare(0, 3, "0-0") == 0)
+	{
+		// El enroque es el movimiento del rey dos columnas hacia la torre
+		bool queenSide = san.compare(0, 5, "O-O-O") == 0 || san.compare(0, 5, "0-0-0") == 0;
+		int homeRow = (pos.sideToMove == WHITE) ? 0 : 7;
+		for (const ChessMove& move : moves)
+		{
+			if (move.fromRow == homeRow && move.fromCol == 4 && move.toRow == homeRow && move.toCol == (queenSide ? 2 : 6) &&
+				pos.board[move.fromRow][move.fromCol].type == KING)
+			{
+				result = move;
+				return true;
+			}
+		}
+		error = "enroque ilegal";
+		return false;
+	}
+
+	PieceType promotion = EMPTY;
+	size_t equals = san.find('=');
+	if (equals != std::string::npos)
+	{
+		promotion = (equals + 1 < san.size()) ? PieceFromLetter(san[equals + 1]) : EMPTY;
+		san.erase(equals);
+	}
+	else if (san.size() > 2 && PieceFromLetter(san.back()) != EMPTY && san[0] >= 'a' && san[0] <= 'h')
+	{
+		promotion = PieceFromLetter(san.back()); // "e8Q"
+		san.pop_back();
+	}
+
+	PieceType type = PAWN;
+	size_t pos0 = 0;
+	if (!san.empty() && PieceFromLetter(san[0]) != EMPTY)
+	{
+		type = PieceFromLetter(san[0]);
+		pos0 = 1;
+	}
+	if (san.size() < pos0 + 2)
+	{
+		error = "jugada mal formada";
+		return false;
+	}
+
+	int toCol = san[san.size() - 2] - 'a';
+	int toRow = san[san.size() - 1] - '1';
+	if (toCol < 0 || toCol >= 8 || toRow < 0 || toRow >= 8)
+	{
+		error = "casilla destino mal formada";
+		return false;
+	}
+
+	// Lo que queda entre la pieza y el destino sirve para desambiguar (columna y/o fila)
+	int fromCol = -1, fromRow = -1;
+	for (size_t i = pos0; i < san.size() - 2; i++)
+	{
+		char ch = san[i];
+		if (ch >= 'a' && ch <= 'h')
+		{
+			fromCol = ch - 'a';
+		}
+		else if (ch >= '1' && ch <= '8')
+		{
+			fromRow = ch - '1';
+		}
+		else if (ch != 'x' && ch != ':' && ch != '-')
+		{
+			error = "jugada mal formada";
+			return false;
+		}
+	}
+
+	int matches = 0;
+	for (const ChessMove& move : moves)
+	{
+		if (move.toRow != toRow || move.toCol != toCol || move.promotion != promotion ||
+			pos.board[move.fromRow][move.fromCol].type != type ||
+			(fromCol >= 0 && move.fromCol != fromCol) || (fromRow >= 0 && move.fromRow != fromRow))
+		{
+			continue;
+		}
+		result = move;
+		matches++;
+	}
+	if (matches == 0)
+	{
+		error = "movimiento invalido";
+		return false;
+	}
+	if (matches > 1)
+	{
+		error = "jugada ambigua";
+		return false;
+	}
+	return true;
+}
+
+// Reproduce las jugadas de una partida desde su posición inicial
+inline PgnReplay ReplayPgnGame(const PgnGame& game)
+{
+	PgnReplay replay;
+	std::string fen = game.GetTag("FEN");
+	if (!LoadFEN(replay.start, fen.empty() ? START_FEN : fen))
+	{
+		replay.error = "FEN invalido";
+		return replay;
+	}
+
+	std::vector<std::string> sanMoves;
+	TokenizeMovetext(game.movetext, sanMoves);
+
+	Position pos = replay.start;
+	std::vector<ChessMove> moves;
+	MoveUndo undo;
+	replay.moves.reserve(sanMoves.size());
+	for (const std::string& san : sanMoves)
+	{
+		GenerateMoves(pos, moves);
+		ChessMove move;
+		if (!ResolveSan(pos, moves, san, move, replay.error))
+		{
+			replay.badMove = san;
+			return replay;
+		}
+		MakeMove(pos, move, undo);
+		replay.moves.push_back(move);
+	}
+	replay.legal = true;
+	return replay;
+}
+
+inline int RunPgnValidator(const std::string& path, int numThreads, std::ostream& out)
+{
+	PgnReader reader;
+	if (!reader.Open(path))
+	{
+		std::cerr << "ERROR::PGN::NO_SE_PUDO_ABRIR " << path << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const size_t BATCH_SIZE = 1024;
+	ThreadPool pool(numThreads);
+	std::vector<PgnGame> games(BATCH_SIZE);
+	std::vector<PgnReplay> replays(BATCH_SIZE);
+
+	long long total = 0, rejected = 0, plies = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	bool moreGames = true;
+	while (moreGames)
+	{
+		size_t count = 0;
+		while (count < BATCH_SIZE && (moreGames = reader.Next(games[count])))
+		{
+			count++;
+		}
+
+		pool.ParallelFor(count, [&](size_t i, int) {
+			replays[i] = ReplayPgnGame(games[i]);
+		});
+
+		for (size_t i = 0; i < count; i++)
+		{
+			total++;
+			const PgnReplay& replay = replays[i];
+			plies += (long long)replay.moves.size();
+			if (!replay.legal)
+			{
+				rejected++;
+				out << "Partida " << total << " rechazada en la jugada " << (replay.moves.size() + 1)
+					<< " '" << replay.badMove << "': " << replay.error << std::endl;
+			}
+			// Libera la memoria de las jugadas antes del siguiente lote
+			replays[i] = PgnReplay();
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cerr << "Partidas: " << total << "  aceptadas: " << (total - rejected) << "  rechazadas: " << rejected
+		<< "  jugadas: " << plies << "  hilos: " << pool.Size() << std::endl;
+	std::cerr << "Tiempo: " << std::fixed << std::setprecision(3) << seconds << " s  ("
+		<< std::setprecision(0) << (seconds > 0.0 ? total / seconds : 0.0) << " partidas/s)" << std::endl;
+	return (rejected == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+// Dibujo instanciado de las piezas.
+// Muchas piezas comparten modelo (ocho peones con pollo, ocho con esqueleto, dos torres, ...).
+// En lugar de una llamada de dibujo por pieza, cada cuadro las piezas pasan por una cola
+// ordenada (RenderQueue.h) con clave piel/modelo/distancia: quedan agrupadas por modelo y,
+// dentro de cada modelo, de la más cercana a la cámara a la más lejana. Las transformaciones
+// y los colores de resaltado de todas las piezas se suben juntos a un solo búfer de
+// instancias en ese orden, y cada malla de cada grupo se vuelve un comando
+// de dibujo indirecto sobre la geometría compartida (GeometryPool.h). Los comandos seguidos
+// con el mismo material se envían en una sola llamada glMultiDrawElementsIndirect; sin esa
+// extensión cada comando es un glDrawElementsInstancedBaseVertex. Las pieles de todas las
+// piezas están en un mismo arreglo de texturas (PieceSkinArray.h), así que las mallas no
+// enlazan texturas propias y en la práctica todas las piezas salen en un solo envío.
+//
+// La cola y los búferes en CPU conservan su capacidad entre cuadros, así que después de los
+// primeros cuadros agrupar no reserva memoria.
+
+#include <vector>
+#include <cstdint>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "Model.h"
+#include "PieceSkinArray.h"
+#include "RenderQueue.h"
+
+class PieceBatcher
+{
+public:
+	// Requiere el contexto de OpenGL. skins debe vivir mientras se use el batcher.
+	void Init(const PieceSkinArray& skins)
+	{
+		this->skins = &skins;
+		glGenBuffers(1, &this->instanceVBO);
+		glGenBuffers(1, &this->commandBuffer);
+		this->multiDraw = SharedGeometry().SupportsMultiDrawIndirect();
+
+		// El VAO compartido queda con los atributos por copia activados, así que también los lee
+		// quien dibuja sin instancias (el tablero): el búfer nunca debe estar vacío
+		this->bufferBytes = INITIAL_INSTANCES * sizeof(MeshInstance);
+		GLState().BindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+		glBufferData(GL_ARRAY_BUFFER, this->bufferBytes, nullptr, GL_STREAM_DRAW);
+		SharedGeometry().PointInstances(this->instanceVBO, 0);
+	}
+
+	// Empieza un cuadro nuevo visto desde eye: vacía la cola sin liberar su memoria
+	void Begin(const glm::vec3& eye)
+	{
+		this->eye = eye;
+		this->instances.clear();
+		this->queue.Clear();
+	}
+
+	// normalMatrix es transpose(inverse(mat3(transform))), calculada una vez por pieza (PieceTransformCache)
+	void Add(Model* model, const glm::mat4& transform, const glm::mat3& normalMatrix, const glm::vec3& highlight)
+	{
+		uint32_t modelId = this->modelIdFor(model);
+		MeshInstance instance;
+		instance.model = transform;
+		instance.normal = normalMatrix;
+		instance.highlight = highlight;
+		instance.skinLayer = this->models[modelId].skinLayer;
+		float depth = glm::length(glm::vec3(transform[3]) - this->eye);
+		this->queue.Push(RenderQueue::MakeKey(0, (uint32_t)instance.skinLayer, modelId, depth), (uint32_t)this->instances.size());
+		this->instances.push_back(instance);
+	}
+
+	// Ordena las piezas, sube sus instancias y dibuja cada grupo con shader (Shader/instanced.vs)
+	void Draw(const Shader& shader)
+	{
+		this->drawCalls = 0;
+		this->instanceCount = 0;
+		this->uploadBuffer.clear();
+		this->commands.clear();
+		this->commandMeshes.clear();
+		this->queue.Sort();
+
+		// Cada tramo de elementos con el mismo modelo es un grupo de copias contiguas en el búfer
+		const std::vector<RenderItem>& items = this->queue.Items();
+		size_t first = 0;
+		while (first < items.size())
+		{
+			uint64_t state = RenderQueue::StateOf(items[first].key);
+			size_t last = first;
+			GLuint baseInstance = (GLuint)this->uploadBuffer.size();
+			while (last < items.size() && RenderQueue::StateOf(items[last].key) == state)
+			{
+				this->uploadBuffer.push_back(this->instances[items[last].payload]);
+				last++;
+			}
+			Model* model = this->models[(state & 0xFFFF)].model;
+			for (Mesh& mesh : model->Meshes())
+			{
+				DrawElementsIndirectCommand command;
+				command.count = mesh.Range().indexCount;
+				command.instanceCount = (GLuint)(last - first);
+				command.firstIndex = mesh.Range().firstIndex;
+				command.baseVertex = mesh.Range().baseVertex;
+				command.baseInstance = baseInstance;
+				this->commands.push_back(command);
+				this->commandMeshes.push_back(&mesh);
+			}
+			first = last;
+		}
+		if (this->uploadBuffer.empty())
+		{
+			return;
+		}
+		this->instanceCount = (int)this->uploadBuffer.size();
+
+		GLsizeiptr bytes = (GLsizeiptr)(this->uploadBuffer.size() * sizeof(MeshInstance));
+		GLState().BindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+		if (bytes > this->bufferBytes)
+		{
+			this->bufferBytes = bytes;
+			glBufferData(GL_ARRAY_BUFFER, bytes, this->uploadBuffer.data(), GL_STREAM_DRAW);
+		}
+		else
+		{
+			// Se descarta el contenido anterior para no esperar a que la GPU termine de leerlo
+			glBufferData(GL_ARRAY_BUFFER, this->bufferBytes, nullptr, GL_STREAM_DRAW);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, this->uploadBuffer.data());
+		}
+
+		shader.Use();
+		this->skins->Bind(SKIN_UNIT);
+		if (this->multiDraw)
+		{
+			this->drawIndirect(shader);
+		}
+		else
+		{
+			this->drawBaseVertex(shader);
+		}
+	}
+
+	// Envíos de dibujo y piezas del último Draw
+	int DrawCalls() const
+	{
+		return this->drawCalls;
+	}
+
+	int InstanceCount() const
+	{
+		return this->instanceCount;
+	}
+
+	// Orden del último Draw (cambios de estado hechos y evitados)
+	const RenderQueue& Queue() const
+	{
+		return this->queue;
+	}
+
+private:
+	struct ModelEntry
+	{
+		Model* model;
+		GLfloat skinLayer;
+	};
+
+	static const size_t INITIAL_INSTANCES = 64;
+	static const GLuint SKIN_UNIT = 0;		// Unidad del sampler pieceSkins de instanced.frag
+
+	const PieceSkinArray* skins = nullptr;
+	GLuint instanceVBO = 0;
+	GLsizeiptr bufferBytes = 0;
+	GLuint commandBuffer = 0;
+	GLsizeiptr commandBytes = 0;
+	bool multiDraw = false;					// glMultiDrawElementsIndirect disponible
+	std::vector<ModelEntry> models;			// El índice es el id de malla en la clave de la cola
+	glm::vec3 eye;
+	std::vector<MeshInstance> instances;	// En el orden de Add; la cola guarda índices a este vector
+	RenderQueue queue;
+	std::vector<MeshInstance> uploadBuffer;
+	std::vector<DrawElementsIndirectCommand> commands;
+	std::vector<Mesh*> commandMeshes;		// Malla de cada comando, para su material
+	int drawCalls = 0;
+	int instanceCount = 0;
+
+	// Sube la tabla de comandos y envía cada tramo de comandos con el mismo material de una vez.
+	// baseInstance de cada comando elige sus copias, así que los atributos por copia apuntan
+	// siempre al inicio del búfer.
+	void drawIndirect(const Shader& shader)
+	{
+		GLsizeiptr bytes = (GLsizeiptr)(this->commands.size() * sizeof(DrawElementsIndirectCommand));
+		GLState().BindBuffer(GL_DRAW_INDIRECT_BUFFER, this->commandBuffer);
+		if (bytes > this->commandBytes)
+		{
+			this->commandBytes = bytes;
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, bytes, this->commands.data(), GL_STREAM_DRAW);
+		}
+		else
+		{
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, this->commandBytes, nullptr, GL_STREAM_DRAW);
+			glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, bytes, this->commands.data());
+		}
+
+		SharedGeometry().PointInstances(this->instanceVBO, 0);
+		size_t first = 0;
+		while (first < this->commands.size())
+		{
+			size_t last = first + 1;
+			while (last < this->commands.size() && this->commandMeshes[last]->SameMaterial(*this->commandMeshes[first]))
+			{
+				last++;
+			}
+			this->commandMeshes[first]->BindMaterial(shader);
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+				(const GLvoid *)(first * sizeof(DrawElementsIndirectCommand)), (GLsizei)(last - first), 0);
+			this->drawCalls++;
+			first = last;
+		}
+	}
+
+	// Sin dibujo indirecto: una llamada por comando, moviendo los atributos por copia al
+	// inicio de cada grupo porque glDrawElementsInstancedBaseVertex no tiene baseInstance
+	void drawBaseVertex(const Shader& shader)
+	{
+		GLuint pointedInstance = (GLuint)-1;
+		for (size_t i = 0; i < this->commands.size(); i++)
+		{
+			const DrawElementsIndirectCommand& command = this->commands[i];
+			if (command.baseInstance != pointedInstance)
+			{
+				SharedGeometry().PointInstances(this->instanceVBO, (GLintptr)(command.baseInstance * sizeof(MeshInstance)));
+				pointedInstance = command.baseInstance;
+			}
+			this->commandMeshes[i]->BindMaterial(shader);
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+				(const GLvoid *)(command.firstIndex * sizeof(GLuint)), command.instanceCount, command.baseVertex);
+			this->drawCalls++;
+		}
+		// El tablero vuelve a leer la primera copia
+		SharedGeometry().PointInstances(this->instanceVBO, 0);
+	}
+
+	// Hay una docena de modelos: una búsqueda lineal basta. Los ids se conservan entre cuadros.
+	uint32_t modelIdFor(Model* model)
+	{
+		for (size_t i = 0; i < this->models.size(); i++)
+		{
+			if (this->models[i].model == model)
+			{
+				return (uint32_t)i;
+			}
+		}
+		this->models.push_back(ModelEntry{ model, this->skins->Layer(model) });
+		return (uint32_t)(this->models.size() - 1);
+	}
+};
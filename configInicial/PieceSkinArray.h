@@ -0,0 +1,147 @@
+#pragma once
+
+// Las texturas de todas las piezas en un solo GL_TEXTURE_2D_ARRAY.
+// Cada modelo de pieza usa una sola piel (steve.png, warden.png, ...), así que cada piel es
+// una capa del arreglo y cada copia dibujada lleva su capa como atributo (MeshInstance::skinLayer).
+// Con el arreglo enlazado una vez, todas las piezas se dibujan sin cambiar de textura.
+//
+// Las capas de un arreglo miden lo mismo: las pieles más chicas (64x64 frente a los 256x256
+// del dragón) se amplían al cargar repitiendo cada píxel, que en texturas pixeladas no cambia
+// cómo se ven y deja las coordenadas UV de los modelos intactas.
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include <GL/glew.h>
+#include "SOIL2/SOIL2.h"
+
+#include "Model.h"
+#include "GLStateCache.h"
+
+class PieceSkinArray
+{
+public:
+	// Carga la primera textura difusa de cada modelo como una capa. Los modelos con la misma
+	// piel comparten capa. Requiere el contexto de OpenGL.
+	void Build(Model* const* models, size_t count)
+	{
+		struct Skin
+		{
+			string file;
+			int width, height;
+			unsigned char* pixels;
+		};
+		vector<Skin> skins;
+		this->layers.clear();
+		int width = 1, height = 1;
+		for (size_t i = 0; i < count; i++)
+		{
+			string file = models[i]->Directory() + '/' + firstDiffuse(*models[i]);
+			size_t layer = 0;
+			while (layer < skins.size() && skins[layer].file != file)
+			{
+				layer++;
+			}
+			if (layer == skins.size())
+			{
+				Skin skin;
+				skin.file = file;
+				skin.pixels = SOIL_load_image(file.c_str(), &skin.width, &skin.height, 0, SOIL_LOAD_RGB);
+				if (skin.pixels == nullptr)
+				{
+					std::cerr << "ERROR::SKINS::NO_SE_PUDO_CARGAR " << file << std::endl;
+					skin.width = skin.height = 0;
+				}
+				width = std::max(width, skin.width);
+				height = std::max(height, skin.height);
+				skins.push_back(skin);
+			}
+			this->layers.push_back(ModelLayer{ models[i], (GLfloat)layer });
+		}
+
+		glGenTextures(1, &this->texture);
+		GLState().BindTexture(0, GL_TEXTURE_2D_ARRAY, this->texture);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, width, height, (GLsizei)skins.size(), 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+		vector<unsigned char> scaled((size_t)width * height * 3, 0);
+		for (size_t layer = 0; layer < skins.size(); layer++)
+		{
+			const Skin& skin = skins[layer];
+			if (skin.pixels == nullptr)
+			{
+				continue; // La capa queda negra
+			}
+			// Vecino más cercano: cada píxel destino toma el píxel de la piel que le cae encima
+			for (int y = 0; y < height; y++)
+			{
+				const unsigned char* row = skin.pixels + (size_t)(y * skin.height / height) * skin.width * 3;
+				for (int x = 0; x < width; x++)
+				{
+					const unsigned char* texel = row + (size_t)(x * skin.width / width) * 3;
+					std::copy(texel, texel + 3, scaled.begin() + ((size_t)y * width + x) * 3);
+				}
+			}
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE, scaled.data());
+			SOIL_free_image_data(skin.pixels);
+		}
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+		// Parameters (los mismos que TextureFromFile)
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		GLState().BindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+		this->layerCount = (int)skins.size();
+	}
+
+	// Capa de la piel de model (0 si el modelo no estaba en Build)
+	GLfloat Layer(const Model* model) const
+	{
+		for (const ModelLayer& entry : this->layers)
+		{
+			if (entry.model == model)
+			{
+				return entry.layer;
+			}
+		}
+		return 0.0f;
+	}
+
+	void Bind(GLuint unit) const
+	{
+		GLState().BindTexture(unit, GL_TEXTURE_2D_ARRAY, this->texture);
+	}
+
+	int LayerCount() const
+	{
+		return this->layerCount;
+	}
+
+private:
+	struct ModelLayer
+	{
+		const Model* model;
+		GLfloat layer;
+	};
+
+	GLuint texture = 0;
+	int layerCount = 0;
+	vector<ModelLayer> layers;		// Hay una docena de modelos: se buscan en orden
+
+	static string firstDiffuse(Model& model)
+	{
+		for (const Mesh& mesh : model.Meshes())
+		{
+			for (const Texture& texture : mesh.textures)
+			{
+				if (texture.type == "texture_diffuse")
+				{
+					return texture.path.C_Str();
+				}
+			}
+		}
+		return string();
+	}
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+// Matrices de mundo (y de normales) de las piezas, calculadas solo cuando cambian.
+// Una pieza solo cambia de lugar al moverse, en cada paso de su animación o cuando se
+// cambia la posición entera (nueva partida, reproducción, estilos). Quien hace esos cambios
+// marca la casilla con InvalidateSquare o todo con InvalidateAll; el resto de los cuadros las
+// matrices salen de la caché sin ninguna cuenta.
+//
+// Las matrices no van en ChessPiece: el motor copia tableros enteros al buscar y no las necesita.
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "ChessRules.h"
+
+struct PieceTransform
+{
+	glm::mat4 world;
+	glm::mat3 normal;	// transpose(inverse(mat3(world))): orienta las normales con escalas no uniformes
+};
+
+class PieceTransformCache
+{
+public:
+	// squarePosition da el centro de una casilla y capturedPosition el lugar de la i-ésima pieza
+	// capturada de un color (GetWorldCoordinates y GetCapturedCoordinates en Ajedrez.cpp)
+	PieceTransformCache(glm::vec3(*squarePosition)(int row, int col), glm::vec3(*capturedPosition)(PieceColor color, size_t index))
+		: squarePosition(squarePosition), capturedPosition(capturedPosition)
+	{
+		this->InvalidateAll();
+	}
+
+	void InvalidateSquare(int row, int col)
+	{
+		this->squareDirty[row][col] = true;
+	}
+
+	// Todas las casillas y las piezas capturadas de los dos colores
+	void InvalidateAll()
+	{
+		for (int r = 0; r < 8; ++r)
+		{
+			for (int c = 0; c < 8; ++c)
+			{
+				this->squareDirty[r][c] = true;
+			}
+		}
+		this->capturedValid[0] = this->capturedValid[1] = 0;
+	}
+
+	// Transformación de la pieza en (row, col), con su desplazamiento de animación
+	const PieceTransform& Square(int row, int col, const ChessPiece& piece)
+	{
+		PieceTransform& transform = this->squares[row][col];
+		if (this->squareDirty[row][col])
+		{
+			this->compose(transform, this->squarePosition(row, col) + piece.positionOffset, piece);
+			this->squareDirty[row][col] = false;
+		}
+		return transform;
+	}
+
+	// Transformación de la index-ésima pieza capturada de color. Las capturadas solo se agregan
+	// al final de su lista, así que se piden en orden y las ya calculadas siguen valiendo.
+	const PieceTransform& Captured(PieceColor color, size_t index, const ChessPiece& piece)
+	{
+		int side = (color == WHITE) ? 0 : 1;
+		std::vector<PieceTransform>& list = this->captured[side];
+		if (index >= this->capturedValid[side])
+		{
+			if (index >= list.size())
+			{
+				list.resize(index + 1); // Solo al capturar más piezas que nunca antes
+			}
+			this->compose(list[index], this->capturedPosition(color, index), piece);
+			this->capturedValid[side] = index + 1;
+		}
+		return list[index];
+	}
+
+	// Matrices calculadas desde el inicio
+	uint64_t Recomputed() const
+	{
+		return this->recomputed;
+	}
+
+private:
+	glm::vec3(*squarePosition)(int row, int col);
+	glm::vec3(*capturedPosition)(PieceColor color, size_t index);
+	PieceTransform squares[8][8];
+	bool squareDirty[8][8];
+	std::vector<PieceTransform> captured[2];	// Blancas y negras
+	size_t capturedValid[2];					// Las primeras capturedValid de cada lista están al día
+	uint64_t recomputed = 0;
+
+	void compose(PieceTransform& transform, const glm::vec3& position, const ChessPiece& piece)
+	{
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+		if (piece.rotationY != 0.0f)
+		{
+			model = glm::rotate(model, piece.rotationY, glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+		transform.world = glm::scale(model, piece.scale);
+		transform.normal = glm::transpose(glm::inverse(glm::mat3(transform.world)));
+		this->recomputed++;
+	}
+};
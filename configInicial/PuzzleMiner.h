@@ -0,0 +1,283 @@
+#pragma once
+
+// Extracción de problemas tácticos de un corpus de partidas.
+// Las partidas se leen por lotes (PGN o archivo binario de GameArchive.h) y cada lote pasa
+// por dos etapas en paralelo:
+//   1. Búsqueda corta con dos líneas (MultiPV 2) en cada posición de cada partida. Es
+//      candidata si la mejor jugada gana claramente y la segunda no: hay una sola táctica.
+//   2. Verificación con una búsqueda más profunda de cada candidata. Se acepta si la mejor
+//      jugada es la misma y sigue siendo la única que gana.
+// Los problemas aceptados se escriben como líneas EPD con la solución (bm, pv) y la
+// evaluación (ce). Las posiciones repetidas entre partidas se verifican una sola vez.
+//
+// Uso: configInicial.exe --puzzles partidas.(pgn|bin) problemas.epd [hilos] [nodos de la etapa 1]
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <unordered_set>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+#include "ChessRules.h"
+#include "Search.h"
+#include "Pgn.h"
+#include "GameArchive.h"
+#include "ThreadPool.h"
+
+const int PUZZLE_WIN_SCORE = 250;			// La mejor jugada debe ganar al menos esto (centipeones)
+const int PUZZLE_MAX_SECOND = 50;			// y la segunda no puede pasar de esto
+const int PUZZLE_DEEP_FACTOR = 20;			// Nodos de la etapa 2 = nodos de la etapa 1 * este factor
+const size_t PUZZLE_SOLUTION_PLIES = 6;		// Jugadas de la variante que se escriben como solución
+const size_t PUZZLE_TABLE_MB = 4;			// Tabla de cada hilo; se limpia en cada posición
+
+// Partida ya reproducida; valid es false si no se pudo leer su posición inicial
+struct PuzzleGame
+{
+	bool valid = false;
+	Position start;
+	std::vector<ChessMove> moves;
+};
+
+struct PuzzleCandidate
+{
+	long long game = 0;
+	int ply = 0;
+	Position pos;
+	ChessMove shallowMove;		// Mejor jugada según la etapa 1
+	SearchResult deep;
+	bool accepted = false;
+};
+
+// Etapa de la extracción: cuántas posiciones entraron, cuántas pasaron y cuánto tardó
+struct PuzzleStageStats
+{
+	long long input = 0;
+	long long passed = 0;
+	double seconds = 0.0;
+};
+
+// ¿El resultado de una búsqueda MultiPV 2 tiene una única jugada ganadora?
+inline bool IsSingleWinningMove(const SearchResult& result)
+{
+	if (result.lines.empty() || result.lines[0].score < PUZZLE_WIN_SCORE)
+	{
+		return false;
+	}
+	return result.lines.size() < 2 || result.lines[1].score <= PUZZLE_MAX_SECOND;
+}
+
+class PuzzleMiner
+{
+public:
+	PuzzleMiner(ThreadPool& pool, uint64_t shallowNodes, std::ostream& out)
+		: pool(pool), searchers(pool.Size()), threadCandidates(pool.Size()), shallowNodes(shallowNodes), out(out) {}
+
+	// Procesa un lote de partidas ya reproducidas; firstGame es el número de la primera
+	void AddBatch(const std::vector<PuzzleGame>& games, long long firstGame)
+	{
+		// Etapa 1: búsqueda corta en todas las posiciones
+		auto start = std::chrono::steady_clock::now();
+		std::vector<long long> positions(this->pool.Size(), 0);
+		this->pool.ParallelFor(games.size(), [&](size_t i, int threadId) {
+			if (!games[i].valid)
+			{
+				return;
+			}
+			Position pos = games[i].start;
+			MoveUndo undo;
+			for (size_t ply = 0; ply <= games[i].moves.size(); ply++)
+			{
+				positions[threadId]++;
+				SearchResult result = this->search(threadId, pos, this->shallowNodes);
+				if (IsSingleWinningMove(result))
+				{
+					PuzzleCandidate candidate;
+					candidate.game = firstGame + (long long)i;
+					candidate.ply = (int)ply;
+					candidate.pos = pos;
+					candidate.shallowMove = result.bestMove;
+					this->threadCandidates[threadId].push_back(candidate);
+				}
+				if (ply < games[i].moves.size())
+				{
+					MakeMove(pos, games[i].moves[ply], undo);
+				}
+			}
+		});
+		std::vector<PuzzleCandidate> candidates;
+		for (int t = 0; t < this->pool.Size(); t++)
+		{
+			this->shallow.input += positions[t];
+			candidates.insert(candidates.end(), this->threadCandidates[t].begin(), this->threadCandidates[t].end());
+			this->threadCandidates[t].clear();
+		}
+		this->shallow.passed += (long long)candidates.size();
+		this->shallow.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		// Orden de las partidas, y sin posiciones ya vistas en este lote o en los anteriores
+		std::sort(candidates.begin(), candidates.end(), [](const PuzzleCandidate& a, const PuzzleCandidate& b) {
+			return a.game != b.game ? a.game < b.game : a.ply < b.ply;
+		});
+		std::vector<PuzzleCandidate> unique;
+		for (const PuzzleCandidate& candidate : candidates)
+		{
+			if (this->seen.insert(PositionKey(candidate.pos)).second)
+			{
+				unique.push_back(candidate);
+			}
+			else
+			{
+				this->duplicates++;
+			}
+		}
+
+		// Etapa 2: verificación profunda
+		start = std::chrono::steady_clock::now();
+		this->pool.ParallelFor(unique.size(), [&](size_t i, int threadId) {
+			PuzzleCandidate& candidate = unique[i];
+			candidate.deep = this->search(threadId, candidate.pos, this->shallowNodes * PUZZLE_DEEP_FACTOR);
+			candidate.accepted = IsSingleWinningMove(candidate.deep) && candidate.deep.bestMove == candidate.shallowMove;
+		});
+		this->deep.input += (long long)unique.size();
+		for (const PuzzleCandidate& candidate : unique)
+		{
+			if (candidate.accepted)
+			{
+				this->deep.passed++;
+				this->write(candidate);
+			}
+		}
+		this->deep.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void PrintStats(long long games) const
+	{
+		std::cerr << "Partidas: " << games << "  problemas: " << this->deep.passed << "  repetidas: " << this->duplicates << std::endl;
+		printStage("Etapa 1 (corta)", "posiciones", this->shallow);
+		printStage("Etapa 2 (profunda)", "candidatas", this->deep);
+	}
+
+private:
+	ThreadPool& pool;
+	std::vector<std::unique_ptr<Searcher>> searchers;
+	std::vector<std::vector<PuzzleCandidate>> threadCandidates;
+	uint64_t shallowNodes;
+	std::ostream& out;
+	std::unordered_set<uint64_t> seen;
+	PuzzleStageStats shallow;
+	PuzzleStageStats deep;
+	long long duplicates = 0;
+
+	// Cada hilo usa su propio Searcher, creado la primera vez que recibe trabajo
+	SearchResult search(int threadId, const Position& pos, uint64_t nodes)
+	{
+		if (!this->searchers[threadId])
+		{
+			this->searchers[threadId].reset(new Searcher(PUZZLE_TABLE_MB));
+		}
+		this->searchers[threadId]->Hash().Clear();
+		SearchLimits limits;
+		limits.nodes = nodes;
+		limits.multiPV = 2;
+		return this->searchers[threadId]->Search(pos, limits);
+	}
+
+	void write(const PuzzleCandidate& candidate)
+	{
+		// Sin los contadores " 0 1": en EPD solo van tablero, turno, enroque y al paso
+		std::string fen = PositionToFEN(candidate.pos);
+		fen.erase(fen.size() - 4);
+		this->out << fen << " bm " << MoveToString(candidate.deep.bestMove) << "; pv";
+		for (size_t i = 0; i < candidate.deep.pv.size() && i < PUZZLE_SOLUTION_PLIES; i++)
+		{
+			this->out << " " << MoveToString(candidate.deep.pv[i]);
+		}
+		this->out << "; ce " << candidate.deep.score << "; id \"partida " << candidate.game + 1 << " jugada "
+			<< candidate.ply / 2 + 1 << "\";" << std::endl;
+	}
+
+	static void printStage(const char* name, const char* unit, const PuzzleStageStats& stage)
+	{
+		double rejected = (stage.input > 0) ? 100.0 * (stage.input - stage.passed) / stage.input : 0.0;
+		std::cerr << name << ": " << stage.input << " " << unit << " -> " << stage.passed << "  rechazo "
+			<< std::fixed << std::setprecision(1) << rejected << "%  " << std::setprecision(3) << stage.seconds << " s  ("
+			<< std::setprecision(1) << (stage.seconds > 0.0 ? stage.input / stage.seconds : 0.0) << " " << unit << "/s)" << std::endl;
+	}
+};
+
+inline int MinePuzzles(const std::string& inputPath, const std::string& outputPath, int numThreads, uint64_t shallowNodes)
+{
+	std::ofstream out(outputPath);
+	if (!out)
+	{
+		std::cerr << "ERROR::PROBLEMAS::NO_SE_PUDO_CREAR " << outputPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	ThreadPool pool(numThreads);
+	PuzzleMiner miner(pool, shallowNodes, out);
+	const size_t BATCH_SIZE = 256;
+	std::vector<PuzzleGame> batch;
+	long long games = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	GameArchive archive;
+	if (archive.Open(inputPath))
+	{
+		for (uint32_t first = 0; first < archive.GameCount(); first += (uint32_t)BATCH_SIZE)
+		{
+			size_t count = std::min((size_t)(archive.GameCount() - first), BATCH_SIZE);
+			batch.assign(count, PuzzleGame());
+			pool.ParallelFor(count, [&](size_t i, int) {
+				ArchivedGame game;
+				if (archive.ReadGame(first + (uint32_t)i, game))
+				{
+					batch[i].valid = true;
+					batch[i].start = game.start;
+					batch[i].moves = game.moves;
+				}
+			});
+			miner.AddBatch(batch, games);
+			games += (long long)count;
+		}
+	}
+	else
+	{
+		PgnReader reader;
+		if (!reader.Open(inputPath))
+		{
+			std::cerr << "ERROR::PROBLEMAS::NO_SE_PUDO_ABRIR " << inputPath << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::vector<PgnGame> pgnBatch(BATCH_SIZE);
+		bool moreGames = true;
+		while (moreGames)
+		{
+			size_t count = 0;
+			while (count < BATCH_SIZE && (moreGames = reader.Next(pgnBatch[count])))
+			{
+				count++;
+			}
+			batch.assign(count, PuzzleGame());
+			pool.ParallelFor(count, [&](size_t i, int) {
+				// Una partida ilegal se recorre solo hasta su primera jugada rechazada
+				PgnReplay replay = ReplayPgnGame(pgnBatch[i]);
+				batch[i].valid = replay.legal || !replay.badMove.empty();
+				batch[i].start = replay.start;
+				batch[i].moves = replay.moves;
+			});
+			miner.AddBatch(batch, games);
+			games += (long long)count;
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	miner.PrintStats(games);
+	std::cerr << "Tiempo: " << std::fixed << std::setprecision(3) << seconds << " s  (" << pool.Size() << " hilos)" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+// Cola de dibujo ordenada por estado de GPU.
+// Cada elemento lleva una clave de 64 bits y un índice (payload) a los datos de quien lo
+// encoló. La clave junta, de más a menos significativo, programa de shader, material, malla
+// y profundidad, así que al ordenar quedan juntos los elementos que comparten estado y,
+// dentro de cada grupo, los más cercanos a la cámara primero (las piezas opacas tapan lo que
+// está detrás antes de que se sombree: early-z).
+//
+//   63      56 55          40 39          24 23                    0
+//   | programa |   material   |    malla     |     profundidad      |
+//
+// Se ordena con radix sort LSD de 8 bits por pasada, saltando los bytes que son iguales en
+// todas las claves (normalmente el programa y parte del material). Los búferes conservan su
+// capacidad entre cuadros.
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+struct RenderItem
+{
+	uint64_t key;
+	uint32_t payload;
+};
+
+class RenderQueue
+{
+public:
+	static const int DEPTH_BITS = 24;
+
+	// depth es la distancia a la cámara (>= 0). Los bits de un float positivo crecen con su
+	// valor, así que los 24 bits altos sirven de profundidad cuantizada sin fijar un rango.
+	static uint64_t MakeKey(uint32_t program, uint32_t material, uint32_t mesh, float depth)
+	{
+		uint32_t depthBits = 0;
+		if (depth > 0.0f)
+		{
+			std::memcpy(&depthBits, &depth, sizeof(depthBits));
+			depthBits >>= 31 - DEPTH_BITS;
+		}
+		return ((uint64_t)(program & 0xFF) << 56) | ((uint64_t)(material & 0xFFFF) << 40)
+			| ((uint64_t)(mesh & 0xFFFF) << 24) | depthBits;
+	}
+
+	// Estado de GPU de una clave (sin la profundidad)
+	static uint64_t StateOf(uint64_t key)
+	{
+		return key >> DEPTH_BITS;
+	}
+
+	void Clear()
+	{
+		this->items.clear();
+	}
+
+	void Push(uint64_t key, uint32_t payload)
+	{
+		this->items.push_back(RenderItem{ key, payload });
+	}
+
+	// Ordena por clave. Antes cuenta los cambios de estado que tendría el orden en que se
+	// encolaron, para saber cuántos evita el orden nuevo.
+	void Sort()
+	{
+		this->submittedChanges = countStateChanges();
+
+		// Histograma de los 8 bytes en una sola pasada
+		size_t counts[8][256];
+		std::memset(counts, 0, sizeof(counts));
+		for (const RenderItem& item : this->items)
+		{
+			for (int pass = 0; pass < 8; pass++)
+			{
+				counts[pass][(item.key >> (pass * 8)) & 0xFF]++;
+			}
+		}
+
+		this->scratch.resize(this->items.size());
+		for (int pass = 0; pass < 8; pass++)
+		{
+			size_t* count = counts[pass];
+			if (this->items.empty() || count[(this->items[0].key >> (pass * 8)) & 0xFF] == this->items.size())
+			{
+				continue; // Todas las claves tienen este byte igual: la pasada no movería nada
+			}
+			size_t offset = 0;
+			for (int digit = 0; digit < 256; digit++)
+			{
+				size_t digitCount = count[digit];
+				count[digit] = offset;
+				offset += digitCount;
+			}
+			for (const RenderItem& item : this->items)
+			{
+				this->scratch[count[(item.key >> (pass * 8)) & 0xFF]++] = item;
+			}
+			this->items.swap(this->scratch);
+		}
+
+		this->sortedChanges = countStateChanges();
+	}
+
+	const std::vector<RenderItem>& Items() const
+	{
+		return this->items;
+	}
+
+	// Cambios de estado (programa, material o malla) entre elementos consecutivos del último Sort
+	int StateChanges() const
+	{
+		return this->sortedChanges;
+	}
+
+	// Cambios de estado que se habrían hecho enviando en el orden en que se encoló
+	int StateChangesAvoided() const
+	{
+		return this->submittedChanges - this->sortedChanges;
+	}
+
+private:
+	std::vector<RenderItem> items;
+	std::vector<RenderItem> scratch;
+	int submittedChanges = 0;
+	int sortedChanges = 0;
+
+	// El primer elemento cuenta como un cambio: hay que fijar el estado al menos una vez
+	int countStateChanges() const
+	{
+		int changes = 0;
+		for (size_t i = 0; i < this->items.size(); i++)
+		{
+			if (i == 0 || StateOf(this->items[i].key) != StateOf(this->items[i - 1].key))
+			{
+				changes++;
+			}
+		}
+		return changes;
+	}
+};
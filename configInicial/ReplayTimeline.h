@@ -0,0 +1,63 @@
+#pragma once
+
+// Línea de tiempo de una partida para reproducirla en la ventana.
+// Guarda una copia de la posición cada KEYFRAME_INTERVAL jugadas, de modo que ir a
+// cualquier jugada cuesta copiar la copia más cercana anterior y aplicar a lo más
+// KEYFRAME_INTERVAL - 1 jugadas, en lugar de repetir la partida desde el inicio.
+
+#include <vector>
+
+#include "ChessRules.h"
+
+class ReplayTimeline
+{
+public:
+	static const int KEYFRAME_INTERVAL = 8;
+
+	void Load(const Position& start, const std::vector<ChessMove>& moves)
+	{
+		this->moves = moves;
+		this->keyframes.clear();
+		this->keyframes.reserve(moves.size() / KEYFRAME_INTERVAL + 1);
+
+		Position pos = start;
+		MoveUndo undo;
+		for (size_t ply = 0; ply <= moves.size(); ply++)
+		{
+			if (ply % KEYFRAME_INTERVAL == 0)
+			{
+				this->keyframes.push_back(pos);
+			}
+			if (ply < moves.size())
+			{
+				MakeMove(pos, moves[ply], undo);
+			}
+		}
+	}
+
+	int PlyCount() const
+	{
+		return (int)this->moves.size();
+	}
+
+	const ChessMove& MoveAt(int ply) const
+	{
+		return this->moves[ply];
+	}
+
+	// Posición después de ply jugadas (0 = posición inicial)
+	void PositionAt(int ply, Position& pos) const
+	{
+		int keyframe = ply / KEYFRAME_INTERVAL;
+		pos = this->keyframes[keyframe];
+		MoveUndo undo;
+		for (int i = keyframe * KEYFRAME_INTERVAL; i < ply; i++)
+		{
+			MakeMove(pos, this->moves[i], undo);
+		}
+	}
+
+private:
+	std::vector<ChessMove> moves;
+	std::vector<Position> keyframes;
+};
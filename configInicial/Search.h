@@ -0,0 +1,457 @@
+#pragma once
+
+// Motor de búsqueda sobre las reglas de ChessRules.h: alfa-beta negamax con profundización
+// iterativa, búsqueda de quietud sobre capturas y tabla de transposición.
+//
+// Las jugadas son legales: un bando sin jugadas está mateado si está en jaque (vale
+// -MATE_SCORE más la distancia en jugadas) y ahogado si no (tablas). El resto de la búsqueda
+// trata las puntuaciones más allá de MATE_BOUND como mates.
+//
+// Cada Searcher tiene su propia tabla y sus propias listas de movimientos, así que varios
+// hilos pueden buscar a la vez con un Searcher cada uno sin compartir nada.
+
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include "ChessRules.h"
+#include "LargePages.h"
+
+const int MAX_PLY = 64;
+const int MATE_SCORE = 30000;
+const int MATE_BOUND = MATE_SCORE - MAX_PLY;	// Puntuaciones más allá de esto son mates
+const int INFINITE_SCORE = 32000;
+
+// Valores de material en centipeones. El rey solo cuenta para ordenar capturas.
+inline int PieceValue(PieceType type)
+{
+	static const int values[7] = { 0, 100, 500, 320, 330, 900, 20000 };
+	return values[type];
+}
+
+// Evaluación estática desde el punto de vista del jugador al que le toca mover:
+// material, avance de los peones y centralización de caballos y alfiles.
+inline int Evaluate(const Position& pos)
+{
+	int score = 0;
+	for (int r = 0; r < 8; ++r)
+	{
+		for (int c = 0; c < 8; ++c)
+		{
+			const ChessPiece& piece = pos.board[r][c];
+			if (piece.type == EMPTY || piece.type == KING)
+			{
+				continue;
+			}
+			int value = PieceValue(piece.type);
+			if (piece.type == PAWN)
+			{
+				value += 5 * ((piece.color == WHITE) ? r - 1 : 6 - r);
+			}
+			else if (piece.type == KNIGHT || piece.type == BISHOP)
+			{
+				int centerRow = (r < 4) ? r : 7 - r;
+				int centerCol = (c < 4) ? c : 7 - c;
+				value += 4 * (centerRow + centerCol);
+			}
+			score += (piece.color == WHITE) ? value : -value;
+		}
+	}
+	return (pos.sideToMove == WHITE) ? score : -score;
+}
+
+enum TTBound : uint8_t { TT_NONE, TT_EXACT, TT_LOWER, TT_UPPER };
+
+struct TTEntry
+{
+	uint64_t key = 0;
+	int16_t score = 0;
+	uint16_t move = 0;		// PackMove, 0 si no hay
+	int8_t depth = 0;
+	uint8_t bound = TT_NONE;
+};
+
+// Tabla de transposición de reemplazo siempre, con un número de entradas potencia de dos.
+// La memoria viene de LargePageMemory (páginas de 2 MB cuando el sistema las da).
+class TranspositionTable
+{
+public:
+	explicit TranspositionTable(size_t megabytes, int initThreads = 1)
+	{
+		this->Resize(megabytes, initThreads);
+	}
+
+	// initThreads > 1 limpia la tabla con varios hilos (ver ClearMemory)
+	void Resize(size_t megabytes, int initThreads = 1)
+	{
+		size_t count = AllocateTable(this->memory, megabytes, sizeof(TTEntry), "BUSQUEDA");
+		this->entries = (count > 0) ? (TTEntry*)this->memory.Data() : &this->fallback;
+		this->mask = (count > 0) ? count - 1 : 0;
+		this->Clear(initThreads);
+	}
+
+	void Clear(int numThreads = 1)
+	{
+		ClearMemory(this->entries, (this->mask + 1) * sizeof(TTEntry), numThreads); // Todo en cero es una entrada vacía
+	}
+
+	bool Probe(uint64_t key, TTEntry& entry) const
+	{
+		entry = this->entries[key & this->mask];
+		return entry.bound != TT_NONE && entry.key == key;
+	}
+
+	void Store(uint64_t key, int depth, int score, TTBound bound, uint16_t move)
+	{
+		TTEntry& entry = this->entries[key & this->mask];
+		if (move == 0 && entry.key == key)
+		{
+			move = entry.move; // Conservar el mejor movimiento conocido
+		}
+		entry.key = key;
+		entry.score = (int16_t)score;
+		entry.move = move;
+		entry.depth = (int8_t)depth;
+		entry.bound = bound;
+	}
+
+	size_t SizeInBytes() const
+	{
+		return (this->mask + 1) * sizeof(TTEntry);
+	}
+
+	const LargePageMemory& Memory() const
+	{
+		return this->memory;
+	}
+
+private:
+	LargePageMemory memory;
+	TTEntry* entries = nullptr;
+	size_t mask = 0;
+	// Sin memoria la tabla queda de una entrada: sigue siendo correcta, solo que casi no guarda nada
+	TTEntry fallback;
+};
+
+struct SearchResult;
+
+struct SearchLimits
+{
+	int maxDepth = MAX_PLY - 1;
+	uint64_t nodes = 0;							// 0 = sin límite
+	const std::atomic<bool>* stop = nullptr;	// Otro hilo puede pedir que se detenga
+	int multiPV = 1;							// Número de líneas a buscar (MultiPV)
+	// Se llama desde el hilo de la búsqueda al terminar cada profundidad
+	std::function<void(const SearchResult&)> onIteration;
+};
+
+// Una línea de MultiPV: puntuación y variante desde la raíz
+struct SearchLine
+{
+	int score = 0;
+	std::vector<ChessMove> pv;
+};
+
+struct SearchResult
+{
+	ChessMove bestMove;		// fromRow == -1 si la posición no tiene movimientos
+	int score = 0;
+	int depth = 0;			// Última profundidad terminada
+	uint64_t nodes = 0;
+	std::vector<ChessMove> pv;
+	std::vector<SearchLine> lines;	// Las multiPV mejores líneas, de mejor a peor; lines[0] es pv
+};
+
+class Searcher
+{
+public:
+	explicit Searcher(size_t ttMegabytes = 16) : tt(ttMegabytes) {}
+
+	TranspositionTable& Hash()
+	{
+		return this->tt;
+	}
+
+	SearchResult Search(const Position& root, const SearchLimits& limits)
+	{
+		SearchResult result;
+		this->limits = &limits;
+		this->nodes = 0;
+		this->aborted = false;
+
+		Position pos = root;
+		uint64_t key = PositionKey(pos);
+
+		std::vector<ChessMove> rootMoves;
+		GenerateMoves(pos, rootMoves);
+		if (!rootMoves.empty())
+		{
+			result.bestMove = rootMoves[0]; // Por si no alcanza a terminar ni la profundidad 1
+		}
+
+		// MultiPV: en cada profundidad se busca la raíz una vez por línea, excluyendo las primeras
+		// jugadas de las líneas ya encontradas. Todas las búsquedas comparten la tabla, así que las
+		// líneas siguientes encuentran casi todo el árbol ya ordenado por las anteriores.
+		int lineCount = std::max(1, std::min(limits.multiPV, (int)rootMoves.size()));
+		for (int depth = 1; depth <= limits.maxDepth && !rootMoves.empty(); depth++)
+		{
+			std::vector<SearchLine> lines;
+			this->excludedRootMoves.clear();
+			for (int line = 0; line < lineCount && !this->aborted; line++)
+			{
+				int score = this->negamax(pos, key, depth, 0, -INFINITE_SCORE, INFINITE_SCORE);
+				if (this->aborted || this->pvLength[0] == 0)
+				{
+					break;
+				}
+				SearchLine found;
+				found.score = score;
+				found.pv.assign(this->pvTable[0], this->pvTable[0] + this->pvLength[0]);
+				this->excludedRootMoves.push_back(found.pv[0]);
+				lines.push_back(found);
+			}
+			if (this->aborted)
+			{
+				break; // Profundidad incompleta: se queda el resultado anterior
+			}
+			std::stable_sort(lines.begin(), lines.end(), [](const SearchLine& a, const SearchLine& b) {
+				return a.score > b.score;
+			});
+			result.depth = depth;
+			result.lines = lines;
+			result.score = lines[0].score;
+			result.pv = lines[0].pv;
+			result.bestMove = result.pv[0];
+			result.nodes = this->nodes;
+			if (limits.onIteration)
+			{
+				limits.onIteration(result);
+			}
+			if (lineCount == 1 && (result.score > MATE_BOUND || result.score < -MATE_BOUND))
+			{
+				break; // Mate encontrado: más profundidad no lo cambia
+			}
+		}
+		this->excludedRootMoves.clear();
+		result.nodes = this->nodes;
+		return result;
+	}
+
+private:
+	struct ScoredMove
+	{
+		ChessMove move;
+		int score;
+	};
+
+	TranspositionTable tt;
+	const SearchLimits* limits = nullptr;
+	uint64_t nodes = 0;
+	bool aborted = false;
+
+	// Variante principal triangular: pvTable[ply] guarda la mejor línea desde ply
+	ChessMove pvTable[MAX_PLY][MAX_PLY];
+	int pvLength[MAX_PLY] = {};
+	std::vector<ChessMove> generated[MAX_PLY];
+	std::vector<ScoredMove> ordered[MAX_PLY];
+	std::vector<ChessMove> excludedRootMoves;	// Jugadas de la raíz ya usadas por otras líneas de MultiPV
+
+	void checkLimits()
+	{
+		this->nodes++;
+		if (this->limits->nodes != 0 && this->nodes >= this->limits->nodes)
+		{
+			this->aborted = true;
+		}
+		if (this->limits->stop != nullptr && (this->nodes & 1023) == 0 && this->limits->stop->load(std::memory_order_relaxed))
+		{
+			this->aborted = true;
+		}
+	}
+
+	// Genera y ordena: primero el movimiento de la tabla, luego capturas (víctima más valiosa
+	// con el atacante más barato) y al final el resto en el orden del generador
+	std::vector<ScoredMove>& orderMoves(const Position& pos, int ply, uint16_t ttMove, bool capturesOnly)
+	{
+		std::vector<ChessMove>& moves = this->generated[ply];
+		std::vector<ScoredMove>& list = this->ordered[ply];
+		GenerateMoves(pos, moves);
+		list.clear();
+		for (const ChessMove& move : moves)
+		{
+			const ChessPiece& victim = pos.board[move.toRow][move.toCol];
+			if (capturesOnly && victim.type == EMPTY)
+			{
+				continue;
+			}
+			ScoredMove scored;
+			scored.move = move;
+			scored.score = 0;
+			if (ttMove != 0 && PackMove(move) == ttMove)
+			{
+				scored.score = 1000000;
+			}
+			else if (victim.type != EMPTY)
+			{
+				scored.score = 10 * PieceValue(victim.type) - PieceValue(pos.board[move.fromRow][move.fromCol].type) + 100000;
+			}
+			else if (move.promotion != EMPTY)
+			{
+				scored.score = PieceValue(move.promotion);
+			}
+			list.push_back(scored);
+		}
+		std::stable_sort(list.begin(), list.end(), [](const ScoredMove& a, const ScoredMove& b) {
+			return a.score > b.score;
+		});
+		return list;
+	}
+
+	void updatePv(int ply, const ChessMove& move)
+	{
+		this->pvTable[ply][ply] = move;
+		for (int i = ply + 1; i < this->pvLength[ply + 1]; i++)
+		{
+			this->pvTable[ply][i] = this->pvTable[ply + 1][i];
+		}
+		this->pvLength[ply] = std::max(this->pvLength[ply + 1], ply + 1);
+	}
+
+	int negamax(Position& pos, uint64_t key, int depth, int ply, int alpha, int beta)
+	{
+		this->pvLength[ply] = ply;
+		if (depth <= 0 || ply >= MAX_PLY - 1)
+		{
+			return this->quiescence(pos, ply, alpha, beta);
+		}
+		this->checkLimits();
+		if (this->aborted)
+		{
+			return 0;
+		}
+
+		TTEntry entry;
+		uint16_t ttMove = 0;
+		if (this->tt.Probe(key, entry))
+		{
+			ttMove = entry.move;
+			int ttScore = scoreFromTT(entry.score, ply);
+			if (ply > 0 && entry.depth >= depth &&
+				(entry.bound == TT_EXACT ||
+				(entry.bound == TT_LOWER && ttScore >= beta) ||
+				(entry.bound == TT_UPPER && ttScore <= alpha)))
+			{
+				return ttScore;
+			}
+		}
+
+		std::vector<ScoredMove>& moves = this->orderMoves(pos, ply, ttMove, false);
+		if (moves.empty())
+		{
+			return IsInCheck(pos) ? -(MATE_SCORE - ply) : 0; // Mate o ahogado
+		}
+
+		int originalAlpha = alpha;
+		int best = -INFINITE_SCORE;
+		uint16_t bestMove = 0;
+		MoveUndo undo;
+		for (size_t i = 0; i < moves.size(); i++)
+		{
+			ChessMove move = moves[i].move;
+			if (ply == 0 && std::find(this->excludedRootMoves.begin(), this->excludedRootMoves.end(), move) != this->excludedRootMoves.end())
+			{
+				continue;
+			}
+			uint64_t childKey = KeyAfterMove(key, pos, move);
+			MakeMove(pos, move, undo);
+			int score = -this->negamax(pos, childKey, depth - 1, ply + 1, -beta, -alpha);
+			UnmakeMove(pos, move, undo);
+			if (this->aborted)
+			{
+				return 0;
+			}
+
+			if (score > best)
+			{
+				best = score;
+				bestMove = PackMove(move);
+				if (score > alpha)
+				{
+					alpha = score;
+					this->updatePv(ply, move);
+					if (alpha >= beta)
+					{
+						break;
+					}
+				}
+			}
+		}
+
+		// Una raíz con jugadas excluidas no da el valor real de la posición
+		if (ply > 0 || this->excludedRootMoves.empty())
+		{
+			TTBound bound = (best <= originalAlpha) ? TT_UPPER : (best >= beta) ? TT_LOWER : TT_EXACT;
+			this->tt.Store(key, depth, scoreToTT(best, ply), bound, bestMove);
+		}
+		return best;
+	}
+
+	int quiescence(Position& pos, int ply, int alpha, int beta)
+	{
+		this->pvLength[ply] = ply;
+		this->checkLimits();
+		if (this->aborted)
+		{
+			return 0;
+		}
+
+		int standPat = Evaluate(pos);
+		if (standPat >= beta || ply >= MAX_PLY - 1)
+		{
+			return standPat;
+		}
+		alpha = std::max(alpha, standPat);
+
+		std::vector<ScoredMove>& moves = this->orderMoves(pos, ply, 0, true);
+		if (this->generated[ply].empty())
+		{
+			return IsInCheck(pos) ? -(MATE_SCORE - ply) : 0; // Mate o ahogado (se generan todas las jugadas)
+		}
+		MoveUndo undo;
+		for (size_t i = 0; i < moves.size(); i++)
+		{
+			ChessMove move = moves[i].move;
+			MakeMove(pos, move, undo);
+			int score = -this->quiescence(pos, ply + 1, -beta, -alpha);
+			UnmakeMove(pos, move, undo);
+			if (this->aborted)
+			{
+				return 0;
+			}
+			if (score > alpha)
+			{
+				alpha = score;
+				this->updatePv(ply, move);
+				if (alpha >= beta)
+				{
+					break;
+				}
+			}
+		}
+		return alpha;
+	}
+
+	// Las puntuaciones de mate se guardan relativas al nodo y no a la raíz
+	static int scoreToTT(int score, int ply)
+	{
+		return (score > MATE_BOUND) ? score + ply : (score < -MATE_BOUND) ? score - ply : score;
+	}
+
+	static int scoreFromTT(int score, int ply)
+	{
+		return (score > MATE_BOUND) ? score - ply : (score < -MATE_BOUND) ? score + ply : score;
+	}
+};
@@ -0,0 +1,310 @@
+#pragma once
+
+// Generador de datos de entrenamiento por autojuego.
+// Cada hilo juega partidas completas contra sí mismo buscando un número fijo de nodos por
+// jugada; las primeras jugadas son al azar (con semilla fija por partida) para que las
+// partidas no se repitan. Cada posición jugada se guarda con la puntuación de la búsqueda y
+// el resultado final de la partida en un registro empaquetado de 32 bytes.
+//
+// Estructura del archivo (little-endian):
+//   TrainingHeader
+//   positionCount x PackedPosition
+//
+// Los hilos llenan un búfer propio y lo vuelcan al archivo en bloques, así que la escritura
+// casi nunca los detiene.
+//
+// Uso: configInicial.exe --selfplay datos.bin partidas nodos [hilos]
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+#include "ChessRules.h"
+#include "Search.h"
+#include "ThreadPool.h"
+
+const char TRAINING_MAGIC[4] = { 'A', 'J', 'D', 'T' };
+const uint32_t TRAINING_VERSION = 2;			// 2: state guarda también los derechos de enroque
+const int SELFPLAY_RANDOM_PLIES = 8;		// Jugadas al azar al empezar cada partida
+const int SELFPLAY_MAX_PLIES = 300;			// Tablas si la partida llega a esta longitud
+const size_t SELFPLAY_TABLE_MB = 8;
+const size_t SELFPLAY_FLUSH_RECORDS = 4096;	// Registros que junta cada hilo antes de escribir
+
+struct TrainingHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t recordSize;
+	uint32_t reserved;
+	uint64_t positionCount;
+};
+
+// Posición empaquetada en 32 bytes. Las piezas se listan en el orden de las casillas
+// ocupadas (bit = fila * 8 + columna), cada una en 4 bits: negra << 3 | PieceType.
+// score y result son desde el punto de vista del bando que mueve.
+struct PackedPosition
+{
+	uint64_t occupancy;
+	uint8_t pieces[16];			// Hasta 32 piezas, dos por byte (la primera en los 4 bits bajos)
+	int16_t score;				// Puntuación de la búsqueda en centipeones
+	uint16_t move;				// Jugada elegida (PackMove)
+	uint16_t ply;				// Número de medio movimiento dentro de la partida
+	int8_t result;				// 1 ganó el bando que mueve, 0 tablas, -1 perdió
+	uint8_t state;				// Bit 0: turno (0 blancas, 1 negras); bits 1-4: derechos de enroque (CASTLE_*)
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition debe ocupar 32 bytes");
+
+// Devuelve false si la posición tiene más de 32 piezas y no cabe en el registro
+inline bool PackPosition(const Position& pos, PackedPosition& packed)
+{
+	std::memset(&packed, 0, sizeof(packed));
+	int count = 0;
+	for (int square = 0; square < 64; square++)
+	{
+		const ChessPiece& piece = pos.board[square / 8][square % 8];
+		if (piece.type == EMPTY)
+		{
+			continue;
+		}
+		if (count == 32)
+		{
+			return false;
+		}
+		uint8_t nibble = (uint8_t)(((piece.color == BLACK) ? 8 : 0) | piece.type);
+		packed.pieces[count / 2] |= (count % 2 == 0) ? nibble : (uint8_t)(nibble << 4);
+		packed.occupancy |= 1ull << square;
+		count++;
+	}
+	packed.state = (uint8_t)(((pos.sideToMove == BLACK) ? 1 : 0) | (pos.castling << 1));
+	return true;
+}
+
+inline void UnpackPosition(const PackedPosition& packed, Position& pos)
+{
+	ClearBoard(pos.board);
+	int count = 0;
+	for (int square = 0; square < 64; square++)
+	{
+		if ((packed.occupancy & (1ull << square)) == 0)
+		{
+			continue;
+		}
+		uint8_t nibble = (packed.pieces[count / 2] >> ((count % 2) * 4)) & 15;
+		ChessPiece& piece = pos.board[square / 8][square % 8];
+		piece.type = (PieceType)(nibble & 7);
+		piece.color = (nibble & 8) ? BLACK : WHITE;
+		count++;
+	}
+	pos.sideToMove = (packed.state & 1) ? BLACK : WHITE;
+	pos.castling = (uint8_t)((packed.state >> 1) & CASTLE_ALL);
+	pos.enPassantCol = -1; // La captura al paso no se guarda
+}
+
+// Escritor del archivo compartido por los hilos. Cada hilo junta registros en su propio
+// búfer; solo el volcado toma el candado.
+class TrainingWriter
+{
+public:
+	bool Open(const std::string& path, int numThreads)
+	{
+		this->out.open(path, std::ios::binary | std::ios::trunc);
+		if (!this->out)
+		{
+			return false;
+		}
+		TrainingHeader header = {};
+		this->out.write((const char*)&header, sizeof(header)); // Se reescribe en Close()
+		this->buffers.assign(numThreads, std::vector<PackedPosition>());
+		for (std::vector<PackedPosition>& buffer : this->buffers)
+		{
+			buffer.reserve(SELFPLAY_FLUSH_RECORDS);
+		}
+		this->count = 0;
+		return true;
+	}
+
+	void Add(int threadId, const PackedPosition& record)
+	{
+		std::vector<PackedPosition>& buffer = this->buffers[threadId];
+		buffer.push_back(record);
+		if (buffer.size() >= SELFPLAY_FLUSH_RECORDS)
+		{
+			this->flush(buffer);
+		}
+	}
+
+	bool Close()
+	{
+		for (std::vector<PackedPosition>& buffer : this->buffers)
+		{
+			this->flush(buffer);
+		}
+		TrainingHeader header;
+		std::memcpy(header.magic, TRAINING_MAGIC, sizeof(header.magic));
+		header.version = TRAINING_VERSION;
+		header.recordSize = sizeof(PackedPosition);
+		header.reserved = 0;
+		header.positionCount = this->count;
+		this->out.seekp(0);
+		this->out.write((const char*)&header, sizeof(header));
+		this->out.close();
+		return !this->out.fail();
+	}
+
+	uint64_t Count() const
+	{
+		return this->count;
+	}
+
+private:
+	std::ofstream out;
+	std::mutex mutex;
+	std::vector<std::vector<PackedPosition>> buffers;
+	uint64_t count = 0;
+
+	void flush(std::vector<PackedPosition>& buffer)
+	{
+		if (buffer.empty())
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->out.write((const char*)buffer.data(), buffer.size() * sizeof(PackedPosition));
+		this->count += buffer.size();
+		buffer.clear();
+	}
+};
+
+// Resultado de una partida de autojuego desde el punto de vista de las blancas
+struct SelfPlayGame
+{
+	std::vector<PackedPosition> records;
+	int whiteResult = 0;
+};
+
+// Juega una partida completa con searcher. La partida termina al quedar un bando sin
+// movimientos (mate o ahogado), por triple repetición o al llegar a SELFPLAY_MAX_PLIES.
+inline void PlaySelfPlayGame(Searcher& searcher, uint64_t nodeLimit, uint32_t seed, SelfPlayGame& game)
+{
+	game.records.clear();
+	game.whiteResult = 0;
+	searcher.Hash().Clear();
+	std::mt19937 random(seed);
+	Position pos;
+	LoadFEN(pos, START_FEN);
+	std::unordered_map<uint64_t, int> repetitions;
+	std::vector<ChessMove> moves;
+	MoveUndo undo;
+
+	for (int ply = 0; ply < SELFPLAY_MAX_PLIES; ply++)
+	{
+		if (++repetitions[PositionKey(pos)] >= 3)
+		{
+			break;
+		}
+		ChessMove move;
+		if (ply < SELFPLAY_RANDOM_PLIES)
+		{
+			GenerateMoves(pos, moves);
+			if (moves.empty())
+			{
+				game.whiteResult = !IsInCheck(pos) ? 0 : (pos.sideToMove == WHITE) ? -1 : 1;
+				break;
+			}
+			move = moves[random() % moves.size()];
+		}
+		else
+		{
+			SearchLimits limits;
+			limits.nodes = nodeLimit;
+			SearchResult result = searcher.Search(pos, limits);
+			if (result.bestMove.fromRow < 0)
+			{
+				game.whiteResult = !IsInCheck(pos) ? 0 : (pos.sideToMove == WHITE) ? -1 : 1; // Mate o ahogado
+				break;
+			}
+			move = result.bestMove;
+			PackedPosition record;
+			if (PackPosition(pos, record))
+			{
+				record.score = (int16_t)std::max(-MATE_SCORE, std::min(MATE_SCORE, result.score));
+				record.move = PackMove(move);
+				record.ply = (uint16_t)ply;
+				game.records.push_back(record);
+			}
+		}
+
+		MakeMove(pos, move, undo);
+	}
+
+	for (PackedPosition& record : game.records)
+	{
+		record.result = (int8_t)((record.state & 1) ? -game.whiteResult : game.whiteResult);
+	}
+}
+
+inline int RunSelfPlay(const std::string& outputPath, int gameCount, uint64_t nodeLimit, int numThreads)
+{
+	ThreadPool pool(numThreads);
+	TrainingWriter writer;
+	if (!writer.Open(outputPath, pool.Size()))
+	{
+		std::cerr << "ERROR::AUTOJUEGO::NO_SE_PUDO_CREAR " << outputPath << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<std::unique_ptr<Searcher>> searchers(pool.Size());
+	std::vector<SelfPlayGame> games(pool.Size());
+	std::atomic<int> whiteWins{ 0 }, blackWins{ 0 }, draws{ 0 };
+	auto start = std::chrono::steady_clock::now();
+
+	pool.ParallelFor((size_t)gameCount, [&](size_t i, int threadId) {
+		if (!searchers[threadId])
+		{
+			searchers[threadId].reset(new Searcher(SELFPLAY_TABLE_MB));
+		}
+		SelfPlayGame& game = games[threadId];
+		PlaySelfPlayGame(*searchers[threadId], nodeLimit, (uint32_t)i, game);
+		for (const PackedPosition& record : game.records)
+		{
+			writer.Add(threadId, record);
+		}
+		if (game.whiteResult > 0)
+		{
+			whiteWins++;
+		}
+		else if (game.whiteResult < 0)
+		{
+			blackWins++;
+		}
+		else
+		{
+			draws++;
+		}
+	});
+
+	if (!writer.Close())
+	{
+		std::cerr << "ERROR::AUTOJUEGO::NO_SE_PUDO_ESCRIBIR " << outputPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cerr << "Partidas: " << gameCount << "  (+" << whiteWins << " =" << draws << " -" << blackWins << ")  posiciones: "
+		<< writer.Count() << "  " << (writer.Count() * sizeof(PackedPosition) >> 10) << " KB" << std::endl;
+	std::cerr << "Tiempo: " << std::fixed << std::setprecision(3) << seconds << " s  (" << std::setprecision(1)
+		<< (seconds > 0.0 ? writer.Count() / seconds : 0.0) << " posiciones/s, " << pool.Size() << " hilos)" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -5,8 +5,15 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <unordered_map>
 
 #include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "GLStateCache.h"
+#include "FrameUniforms.h"
 
 class Shader
 {
@@ -84,23 +91,131 @@ public:
 			glGetProgramInfoLog(this->Program, 512, NULL, infoLog);
 			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
 		}
+		// Localidades de todos los uniforms, una sola vez por programa
+		this->cacheUniforms();
+		// El bloque FrameData (cámara y luz del cuadro) lee siempre del búfer de FrameUniforms
+		GLuint frameBlock = glGetUniformBlockIndex(this->Program, FRAME_UNIFORM_BLOCK);
+		if (frameBlock != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding(this->Program, frameBlock, FRAME_UNIFORM_BINDING);
+		}
 		//le damos la localidad de color
-		uniformColor = glGetUniformLocation(this->Program, "color");
+		uniformColor = this->GetUniformLocation("color");
 		// Delete the shaders as they're linked into our program now and no longer necessery
 		glDeleteShader(vertex);
 		glDeleteShader(fragment);
 
 	}
 	// Uses the current shader
-	void Use()
+	void Use() const
 	{
-		glUseProgram(this->Program);
+		GLState().UseProgram(this->Program);
 	}
 
 	GLuint getColorLocation()
 	{
 		return uniformColor;
 	}
+
+	// Localidad de un uniform activo, o -1 si el programa no lo usa (como glGetUniformLocation,
+	// pero sin preguntarle al driver). Conviene guardarla antes del ciclo de render.
+	GLint GetUniformLocation(const std::string& name) const
+	{
+		std::unordered_map<std::string, GLint>::const_iterator found = this->uniforms.find(name);
+		return (found != this->uniforms.end()) ? found->second : -1;
+	}
+
+	// Asignación de uniforms por localidad. El programa debe estar en uso (Use()).
+	void SetInt(GLint location, GLint value) const
+	{
+		glUniform1i(location, value);
+	}
+
+	void SetFloat(GLint location, GLfloat value) const
+	{
+		glUniform1f(location, value);
+	}
+
+	void SetVec3(GLint location, const glm::vec3& value) const
+	{
+		glUniform3fv(location, 1, glm::value_ptr(value));
+	}
+
+	void SetMat3(GLint location, const glm::mat3& value) const
+	{
+		glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+
+	void SetMat4(GLint location, const glm::mat4& value) const
+	{
+		glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+
+	// Asignación por nombre, para la configuración inicial (busca en la tabla en cada llamada)
+	void SetInt(const std::string& name, GLint value) const
+	{
+		this->SetInt(this->GetUniformLocation(name), value);
+	}
+
+	void SetFloat(const std::string& name, GLfloat value) const
+	{
+		this->SetFloat(this->GetUniformLocation(name), value);
+	}
+
+	void SetVec3(const std::string& name, const glm::vec3& value) const
+	{
+		this->SetVec3(this->GetUniformLocation(name), value);
+	}
+
+	void SetMat3(const std::string& name, const glm::mat3& value) const
+	{
+		this->SetMat3(this->GetUniformLocation(name), value);
+	}
+
+	void SetMat4(const std::string& name, const glm::mat4& value) const
+	{
+		this->SetMat4(this->GetUniformLocation(name), value);
+	}
+
+private:
+	std::unordered_map<std::string, GLint> uniforms;
+
+	// Recorre los uniforms activos del programa enlazado y guarda sus localidades
+	void cacheUniforms()
+	{
+		GLint count = 0;
+		GLint maxLength = 0;
+		glGetProgramiv(this->Program, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(this->Program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+		std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+		for (GLint i = 0; i < count; i++)
+		{
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(this->Program, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+			std::string name(buffer.data(), length);
+			GLint location = glGetUniformLocation(this->Program, name.c_str());
+			if (location < 0)
+			{
+				continue; // Uniform dentro de un bloque: no tiene localidad propia
+			}
+			this->uniforms[name] = location;
+
+			// Los arreglos se reportan como "nombre[0]": se guardan también "nombre" y cada elemento
+			size_t bracket = name.find('[');
+			if (bracket != std::string::npos)
+			{
+				std::string base = name.substr(0, bracket);
+				this->uniforms[base] = location;
+				for (GLint element = 1; element < size; element++)
+				{
+					std::string elementName = base + "[" + std::to_string(element) + "]";
+					this->uniforms[elementName] = glGetUniformLocation(this->Program, elementName.c_str());
+				}
+			}
+		}
+	}
 };
 
 #endif
\ No newline at end of file
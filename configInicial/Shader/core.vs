@@ -4,14 +4,23 @@ layout (location = 0) in vec3 position;
 
 out vec3 ourColor;
 
+// Cámara y luz del cuadro, compartidas por todos los programas (FrameUniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 uniform mat4 transform;
 uniform vec3 color;
 
 void main()
 {
-    gl_Position =projection*view*model*vec4(position, 1.0f);
+    gl_Position =viewProjection*model*vec4(position, 1.0f);
     ourColor = color;
 }
\ No newline at end of file
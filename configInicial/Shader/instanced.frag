@@ -0,0 +1,19 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec3 Highlight;              // Color de resaltado de la copia (negro = sin resaltar)
+flat in float SkinLayer;        // Capa de la piel de la pieza en pieceSkins
+
+uniform sampler2DArray pieceSkins;
+
+void main()
+{
+    vec4 baseColor = texture(pieceSkins, vec3(TexCoords, SkinLayer));
+
+    // Igual que lighting.frag: mezcla al 50% si el resaltado está activo
+    float highlightIntensity = step(0.01, max(Highlight.r, max(Highlight.g, Highlight.b)));
+    vec3 finalColor = mix(baseColor.rgb, Highlight, highlightIntensity * 0.5);
+
+    FragColor = vec4(finalColor, baseColor.a);
+}
@@ -0,0 +1,37 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 texCoords;
+// Por copia (glVertexAttribDivisor = 1): transformación del modelo, color de resaltado y capa de la piel
+layout (location = 3) in mat4 instanceModel;
+layout (location = 7) in vec3 instanceHighlight;
+layout (location = 8) in float instanceSkinLayer;
+// Matriz de normales de la copia, calculada en CPU (no se invierte nada por vértice)
+layout (location = 9) in mat3 instanceNormal;
+
+out vec3 Normal;
+out vec3 FragPos;
+out vec2 TexCoords;
+out vec3 Highlight;
+flat out float SkinLayer;
+
+// Cámara y luz del cuadro, compartidas por todos los programas (FrameUniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+};
+
+void main()
+{
+    gl_Position = viewProjection * instanceModel * vec4(position, 1.0f);
+    FragPos = vec3(instanceModel * vec4(position, 1.0f));
+    Normal = instanceNormal * normal;
+    TexCoords = texCoords;
+    Highlight = instanceHighlight;
+    SkinLayer = instanceSkinLayer;
+}
@@ -0,0 +1,37 @@
+#version 330 core
+// Variante de instanced.vs para modelos con la misma escala en los tres ejes (salvo el signo):
+// ahí mat3(model) ya orienta bien las normales y no hace falta la matriz de normales.
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 texCoords;
+// Por copia (glVertexAttribDivisor = 1): transformación del modelo, color de resaltado y capa de la piel
+layout (location = 3) in mat4 instanceModel;
+layout (location = 7) in vec3 instanceHighlight;
+layout (location = 8) in float instanceSkinLayer;
+
+out vec3 Normal;
+out vec3 FragPos;
+out vec2 TexCoords;
+out vec3 Highlight;
+flat out float SkinLayer;
+
+// Cámara y luz del cuadro, compartidas por todos los programas (FrameUniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+};
+
+void main()
+{
+    gl_Position = viewProjection * instanceModel * vec4(position, 1.0f);
+    FragPos = vec3(instanceModel * vec4(position, 1.0f));
+    Normal = normalize(mat3(instanceModel) * normal);
+    TexCoords = texCoords;
+    Highlight = instanceHighlight;
+    SkinLayer = instanceSkinLayer;
+}
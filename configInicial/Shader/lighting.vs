@@ -7,14 +7,24 @@ out vec3 Normal;
 out vec3 FragPos;
 out vec2 TexCoords;
 
+// Cámara y luz del cuadro, compartidas por todos los programas (FrameUniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix;      // transpose(inverse(mat3(model))), calculada en CPU
 
 void main()
 {
-    gl_Position = projection * view *  model * vec4(position, 1.0f);
+    gl_Position = viewProjection * model * vec4(position, 1.0f);
     FragPos = vec3(model * vec4(position, 1.0f));
-    Normal = mat3(transpose(inverse(model))) * normal;
+    Normal = normalMatrix * normal;
     TexCoords = texCoords;
 }
\ No newline at end of file
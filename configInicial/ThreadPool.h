@@ -0,0 +1,123 @@
+#pragma once
+
+// Grupo fijo de hilos para las herramientas de línea de comandos.
+// Los hilos se crean una sola vez y se reutilizan en cada ParallelFor, de modo que
+// procesar un archivo por lotes no paga la creación de hilos en cada lote.
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+class ThreadPool
+{
+public:
+	// numThreads <= 0 usa un hilo por núcleo lógico
+	explicit ThreadPool(int numThreads = 0)
+	{
+		if (numThreads <= 0)
+		{
+			numThreads = (int)std::thread::hardware_concurrency();
+			if (numThreads <= 0)
+			{
+				numThreads = 1;
+			}
+		}
+		for (int i = 0; i < numThreads; i++)
+		{
+			this->workers.emplace_back(&ThreadPool::workerLoop, this, i);
+		}
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->stopping = true;
+		}
+		this->wakeCondition.notify_all();
+		for (std::thread& worker : this->workers)
+		{
+			worker.join();
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int Size() const
+	{
+		return (int)this->workers.size();
+	}
+
+	// Ejecuta job(indice, hilo) para cada indice en [0, count) y espera a que terminen todos.
+	// Los índices se reparten dinámicamente, así que tareas de duración desigual se equilibran solas.
+	void ParallelFor(size_t count, const std::function<void(size_t, int)>& job)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->job = &job;
+			this->jobCount = count;
+			this->nextIndex = 0;
+			this->pending = (int)this->workers.size();
+			this->generation++;
+		}
+		this->wakeCondition.notify_all();
+
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->doneCondition.wait(lock, [this] { return this->pending == 0; });
+		this->job = nullptr;
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+	const std::function<void(size_t, int)>* job = nullptr;
+	size_t jobCount = 0;
+	std::atomic<size_t> nextIndex{ 0 };
+	int pending = 0;
+	unsigned generation = 0;
+	bool stopping = false;
+
+	void workerLoop(int threadId)
+	{
+		unsigned seenGeneration = 0;
+		for (;;)
+		{
+			const std::function<void(size_t, int)>* currentJob;
+			size_t count;
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->wakeCondition.wait(lock, [&] { return this->stopping || this->generation != seenGeneration; });
+				if (this->stopping)
+				{
+					return;
+				}
+				seenGeneration = this->generation;
+				currentJob = this->job;
+				count = this->jobCount;
+			}
+
+			for (size_t i = this->nextIndex++; i < count; i = this->nextIndex++)
+			{
+				(*currentJob)(i, threadId);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				if (--this->pending == 0)
+				{
+					this->doneCondition.notify_all();
+				}
+			}
+		}
+	}
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+// Modo de rendimiento para análisis masivo: en lugar de usar varios hilos en una sola
+// posición, cada hilo busca por su cuenta una posición distinta con su propio Searcher.
+// No hay estado compartido entre hilos, así que el rendimiento debería crecer casi en
+// proporción al número de núcleos.
+//
+// Cada hilo crea su Searcher antes de empezar a medir, de modo que la tabla de
+// transposición se reserva y se llena de ceros desde ese hilo. En sistemas NUMA la política
+// de "primer toque" deja entonces sus páginas en la memoria del nodo donde corre el hilo.
+// El tiempo informado es solo el de las búsquedas: no incluye crear los hilos, reservar las
+// tablas ni leer cuánto de ellas quedó en páginas grandes.
+//
+// Uso: configInicial.exe --throughput suite.epd nodos [hilos máximos]
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+
+#include "ChessRules.h"
+#include "Search.h"
+#include "ThreadPool.h"
+
+struct BatchResult
+{
+	bool parsed = false;
+	SearchResult search;
+};
+
+// Memoria de las tablas de los hilos de un lote
+struct BatchTableStats
+{
+	int tables = 0;
+	int hugePageTables = 0;				// Tablas que obtuvieron páginas grandes (explícitas o transparentes)
+	long long residentHugeBytes = 0;	// -1 si el sistema no permite saberlo
+};
+
+// Busca cada FEN con un límite de nodos. Los resultados quedan en el mismo orden que fens
+// y no dependen del número de hilos: la tabla de cada hilo se limpia antes de cada posición.
+// searchSeconds recibe el tiempo de las búsquedas solas.
+inline std::vector<BatchResult> AnalyzeBatch(const std::vector<std::string>& fens, uint64_t nodeLimit, int numThreads,
+	size_t ttMegabytes = 16, BatchTableStats* tableStats = nullptr, double* searchSeconds = nullptr)
+{
+	ThreadPool pool(numThreads);
+	std::vector<std::unique_ptr<Searcher>> searchers(pool.Size());
+	std::vector<BatchResult> results(fens.size());
+
+	// Un índice por hilo: cada uno espera a que lleguen los demás, así que ningún hilo toma
+	// dos índices y todos crean su propia tabla
+	std::atomic<int> arrived(0);
+	pool.ParallelFor(pool.Size(), [&](size_t, int threadId) {
+		searchers[threadId].reset(new Searcher(ttMegabytes));
+		arrived++;
+		while (arrived.load() < pool.Size())
+		{
+			std::this_thread::yield();
+		}
+	});
+
+	auto start = std::chrono::steady_clock::now();
+	pool.ParallelFor(fens.size(), [&](size_t i, int threadId) {
+		Position pos;
+		results[i].parsed = LoadFEN(pos, fens[i]);
+		if (!results[i].parsed)
+		{
+			return;
+		}
+		searchers[threadId]->Hash().Clear();
+		SearchLimits limits;
+		limits.nodes = nodeLimit;
+		results[i].search = searchers[threadId]->Search(pos, limits);
+	});
+	if (searchSeconds != nullptr)
+	{
+		*searchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	if (tableStats != nullptr)
+	{
+		*tableStats = BatchTableStats();
+		for (const std::unique_ptr<Searcher>& searcher : searchers)
+		{
+			if (!searcher)
+			{
+				continue;
+			}
+			const LargePageMemory& memory = searcher->Hash().Memory();
+			long long hugeBytes = memory.ResidentHugeBytes();
+			tableStats->tables++;
+			tableStats->hugePageTables += (memory.Kind() != PAGES_NORMAL) ? 1 : 0;
+			tableStats->residentHugeBytes = (hugeBytes < 0 || tableStats->residentHugeBytes < 0) ? -1 : tableStats->residentHugeBytes + hugeBytes;
+		}
+	}
+	return results;
+}
+
+// Mide posiciones por segundo con 1, 2, 4, ... hasta maxThreads hilos sobre la misma suite
+inline int RunThroughputBenchmark(const std::string& path, uint64_t nodeLimit, int maxThreads, std::ostream& out)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cerr << "ERROR::THROUGHPUT::NO_SE_PUDO_ABRIR " << path << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::vector<std::string> fens;
+	std::string line;
+	while (std::getline(file, line))
+	{
+		// Solo los cuatro primeros campos de la línea EPD forman la FEN
+		std::istringstream stream(line);
+		std::string fields[4];
+		for (std::string& field : fields)
+		{
+			stream >> field;
+		}
+		if (!fields[0].empty())
+		{
+			fens.push_back(fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3]);
+		}
+	}
+	if (maxThreads <= 0)
+	{
+		maxThreads = (int)std::thread::hardware_concurrency();
+		if (maxThreads <= 0)
+		{
+			maxThreads = 1;
+		}
+	}
+
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	std::vector<BatchResult> results;
+	double baseRate = 0.0;
+	for (int threads : threadCounts)
+	{
+		BatchTableStats tableStats;
+		double seconds = 0.0;
+		results = AnalyzeBatch(fens, nodeLimit, threads, 16, &tableStats, &seconds);
+
+		uint64_t nodes = 0;
+		for (const BatchResult& result : results)
+		{
+			nodes += result.search.nodes;
+		}
+		double rate = (seconds > 0.0) ? fens.size() / seconds : 0.0;
+		if (baseRate == 0.0)
+		{
+			baseRate = rate;
+		}
+		double speedup = (baseRate > 0.0) ? rate / baseRate : 0.0;
+		std::cerr << std::fixed << std::setw(3) << threads << " hilos: " << std::setprecision(3) << seconds << " s  "
+			<< std::setprecision(1) << rate << " posiciones/s  " << std::setprecision(0) << (seconds > 0.0 ? nodes / seconds : 0.0)
+			<< " nodos/s  aceleracion " << std::setprecision(2) << speedup << "x  eficiencia "
+			<< std::setprecision(0) << 100.0 * speedup / threads << "%  tablas con paginas grandes "
+			<< tableStats.hugePageTables << "/" << tableStats.tables;
+		if (tableStats.residentHugeBytes >= 0)
+		{
+			std::cerr << " (" << (tableStats.residentHugeBytes >> 20) << " MB)";
+		}
+		std::cerr << std::endl;
+	}
+
+	int invalid = 0;
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BatchResult& result = results[i];
+		out << (i + 1) << "\t";
+		if (!result.parsed)
+		{
+			invalid++;
+			out << "FEN invalido" << std::endl;
+			continue;
+		}
+		if (result.search.bestMove.fromRow < 0)
+		{
+			out << "sin movimientos" << std::endl;
+			continue;
+		}
+		out << MoveToString(result.search.bestMove) << "\tpuntos=" << result.search.score << "\tprofundidad="
+			<< result.search.depth << "\tnodos=" << result.search.nodes << std::endl;
+	}
+	return invalid == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}